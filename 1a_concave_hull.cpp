@@ -9,8 +9,21 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <algorithm>
+#include <cstdlib>
 #include <set>
 #include <vector>
+#include <deque>
+#include <string_view>
+#include <optional>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <chrono>
+#include <unordered_map>
+#include <limits>
 
 /* For geometry operations */
 #include <geos/geom/GeometryFactory.h>
@@ -22,400 +35,2245 @@
 #include <geos/io/GeoJSONReader.h>
 #include <geos/io/GeoJSONWriter.h>
 
-/* For concave hull */
-#include <geos/algorithm/hull/ConcaveHullOfPolygons.h>
+/* For streaming feature input and output (GeoJSON or WKB feature container) */
+#include "src/feature_io.h"
+#include "src/geojson_feature.h"
 
-/* For directory creation */
-#if __cplusplus >= 201703L
-#include <filesystem>
-#else
-#include <sys/stat.h>
-#include <sys/types.h>
+/* For the adaptive-threshold concave hull */
+#include "src/hull_engine.h"
+#include "src/hull_cache.h"
+#include "src/hull_settings.h"
+
+/* For --eapply, --borough and --bbox */
+#include "src/feature_selection.h"
+
+/* For --simplify */
+#include "src/hull_simplify.h"
+
+/* For --snap */
+#include "src/hull_snap.h"
+
+/* For --hierarchical */
+#include "src/hull_hierarchy.h"
+#include <geos/algorithm/distance/DiscreteHausdorffDistance.h>
+
+/* For --projection */
+#include "src/projection.h"
+
+/* For --stage augment and --output-analysis */
+#include "src/augment_metrics.h"
+#include "src/hull_analysis.h"
+
+/* For --arena; builds with NO_FEATURE_ARENA (the sanitizer variants) keep the global allocator */
+#ifndef NO_FEATURE_ARENA
+#include "src/feature_arena.h"
 #endif
 
+/* For --previous */
+#include "src/previous_output.h"
+
+/* For --sweep */
+#include "src/hull_sweep.h"
+
+/* For the tiny polygon check and temp/issue_geojson */
+#include "src/ring_metrics.h"
+#include "src/issue_writer.h"
+
+/* For --serve */
+#include "src/line_server.h"
+#include <geos/version.h>
+
+/* For --profile and --log */
+#include "src/profile_report.h"
+#include "src/feature_log.h"
+
+/* Parser to worker queue of the batch pipeline */
+#include "src/bounded_queue.h"
+
+/* For --shard and merge */
+#include "src/feature_shard.h"
+
 /* Geometry/GeometryFactory */
 using namespace geos::geom;
 
 /* GeoJSON I/O */
 using namespace geos::io;
 
-/* Concave hull */
-using namespace geos::algorithm::hull;
-
-/* JSON (GEOS vendored version) */
-using json = geos_nlohmann::json;
-
 const char *SOURCE_DATA_FILE = "./output_data/0c_parks_filtered_augmented.geojson";
+const char *AUGMENT_SOURCE_DATA_FILE = "./output_data/0b_parks_filtered.geojson"; // --stage augment input
 const char *OUTPUT_PATH_HULLS = "./output_data/1a_parks_concave_hulls.geojson";
 const char *OUTPUT_PATH_WITH_HULLS = "./output_data/1a_parks_with_concave_hulls.geojson";
 
-// Whitelist of eapply values to process
-// Empty set means process all features
-std::set<std::string> EAPPLY_WHITELIST = {
-    // "Van Voorhees Playground",
-    // "Grand Army Plaza",
-    // "Prospect Park",
-    // "Red Hook Recreation Area",
-    // "Broadway Malls 59th-110th"
-    // Add more park names here as needed
-};
+// Threshold for tiny polygon removal (in square meters)
+const double TINY_POLYGON_AREA_THRESHOLD_SQ_METERS = 500.0; // 100 square meters
+const double SQ_METERS_PER_SQ_DEGREE = METERS_PER_DEGREE * METERS_PER_DEGREE;
+
+/* One GeoJSON file per feature whose hull still has several polygons */
+const char *ISSUE_DIRECTORY = "temp/issue_geojson";
+
+/* Default --queue-depth: features in flight per hull worker */
+const size_t PIPELINE_DEPTH_PER_WORKER = 4;
+
+/* Command line options */
+struct Options
+{
+  unsigned threads = 1;                           // Number of hull workers (0 = one per hardware thread)
+  SearchStrategy search = SearchStrategy::Linear; // How the adaptive threshold is searched
+  std::string cache_dir;                          // Hull cache directory (empty = no cache)
+  std::string input;                              // Empty = the default input of the stage
+  std::string output_hulls = OUTPUT_PATH_HULLS;
+  std::string output_with_hulls = OUTPUT_PATH_WITH_HULLS;
+  std::string output_analysis;                    // Original + hull + 2a shape metrics (empty = none)
+  std::string profile_path;                       // Per-feature timing report (empty = none)
+  LogLevel log_level = LogLevel::Normal;          // How much of the per-feature output reaches the console
+  std::string log_path;                           // Structured per-feature log (empty = none)
+  SelectionCriteria selection;                    // Features to process (empty = all)
+  bool keep_unselected = false;                   // Copy unselected features to the outputs unchanged
+  SimplifySettings simplify;                      // Pre-simplification of hull inputs
+  bool simplify_check = false;                    // Also compute unsimplified hulls and compare
+  SnapSettings snap;                              // Precision grid the hull inputs are snapped to
+  bool snap_check = false;                        // Also run the unsnapped searches and compare
+  HierarchySettings hierarchical;                 // Hull very large multipolygons cluster by cluster
+  bool hierarchical_check = false;                // Also compute their direct hulls and compare
+  bool project_utm = false;                       // Compute hulls in UTM 18N meters instead of degrees
+  bool arena = false;                             // Allocate each feature's temporaries from a per-worker arena
+  bool augment = false;                           // Add the 0c_basic_augment.py fields before the hull (--stage augment)
+  bool serve = false;                             // Answer hull requests instead of a batch run
+  std::string socket_path;                        // --serve on this Unix socket (empty = stdin/stdout)
+  std::string previous_path;                      // Earlier original + concave hull output to reuse hulls from
+  SweepGrid sweep;                                // Hull settings to sweep over (empty = a single run)
+  bool raw_properties = false;                    // Pass input properties through as JSON text (GeoJSON only)
+  double time_budget_s = 0.0;                     // Hull search time per feature (0 = unlimited)
+  size_t queue_depth = 0;                         // Features in flight between reading and writing (0 = 4 per worker)
+  bool merge = false;                             // Merge the outputs of --shard runs instead (merge subcommand)
+  size_t merge_shards = 0;                        // Number of shards to merge
+
+  /* Hull search; only --serve requests change these */
+  float threshold_m = CONCAVE_HULL_LENGTH_THRESHOLD_METERS;
+  float increment_m = CONCAVE_HULL_LENGTH_INCREMENT_METERS;
+  int max_attempts = MAX_ATTEMPTS;
+  bool hulls_only = false; // Skip the original + concave hull record (--serve)
+
+  /* Derived from the paths' extensions */
+  FeatureFormat hulls_format = FeatureFormat::GeoJSON;
+  FeatureFormat with_hulls_format = FeatureFormat::GeoJSON;
+  FeatureFormat analysis_format = FeatureFormat::GeoJSON;
+};
+
+/* --time-budget as a steady_clock duration */
+std::chrono::steady_clock::duration timeBudget(const Options &options)
+{
+  return std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(options.time_budget_s));
+}
+
+/*
+ * Runs `stop` when it goes out of scope, so worker threads are stopped and
+ * joined (or an arena reset) on every way out, including exceptions
+ */
+template <typename Stop>
+class OnScopeExit
+{
+public:
+  explicit OnScopeExit(Stop stop) : stop_(std::move(stop)) {}
+  ~OnScopeExit() { stop_(); }
+
+  OnScopeExit(const OnScopeExit &) = delete;
+  OnScopeExit &operator=(const OnScopeExit &) = delete;
+
+private:
+  Stop stop_;
+};
+
+/*
+ * Settings besides the hull parameters that change the hull, as named in
+ * hull cache keys; `hierarchical` is whether the feature's hull is searched
+ * cluster by cluster (directly computed hulls share keys with runs
+ * without --hierarchical)
+ */
+std::string hullCacheVariant(const Options &options, bool hierarchical)
+{
+  /* Unsnapped entries keep the keys they had before --snap existed */
+  std::string variant = options.simplify.describe();
+  if (options.snap.enabled())
+  {
+    variant += ";snap:" + options.snap.describe();
+  }
+  if (hierarchical)
+  {
+    variant += ";hierarchical:" + options.hierarchical.describe();
+  }
+  return variant;
+}
+
+/* How a file of the given format is described in the console output */
+const char *formatDescription(FeatureFormat format)
+{
+  return format == FeatureFormat::Container ? "feature container" : "GeoJSON file";
+}
+
+void printUsage(const char *program)
+{
+  std::cout << "Usage: " << program << " [--threads N] [--search linear|bisect] [--cache-dir DIR]\n"
+            << "       [--input PATH] [--output-hulls PATH] [--output-with-hulls PATH] [--profile FILE]\n"
+            << "       [--quiet | --verbose] [--log FILE]\n"
+            << "       [--eapply NAME]... [--eapply-file FILE] [--borough B]... [--bbox BOX]... [--keep-unselected]\n"
+            << "       [--simplify off|threshold[:F]|budget:N] [--simplify-check] [--projection degrees|utm18n]\n"
+            << "       [--snap off|GRID] [--snap-check] [--hierarchical off|N[:K]] [--hierarchical-check]\n"
+            << "       [--arena] [--serve [--socket PATH]] [--previous PATH] [--stage hull|augment]\n"
+            << "       [--output-analysis PATH] [--sweep AXIS=V1,V2,...]... [--raw-properties]\n"
+            << "       [--time-budget SECONDS] [--queue-depth N] [--shard I/N[:id|tile]]\n"
+            << "       " << program << " merge --shards N [--output-hulls PATH] [--output-with-hulls PATH]\n"
+            << "       [--output-analysis PATH]\n"
+            << "  --threads N       Compute hulls on N worker threads (0 = one per core, default 1)\n"
+            << "  --search STRATEGY Threshold search: 'linear' tries every increment (default),\n"
+            << "                    'bisect' doubles the increment until a single polygon is\n"
+            << "                    found, then bisects back to the smallest such threshold\n"
+            << "  --cache-dir DIR   Reuse hulls computed by earlier runs for unchanged geometries\n"
+            << "  --input PATH, --output-hulls PATH, --output-with-hulls PATH\n"
+            << "                    Override the default file locations; paths ending in\n"
+            << "                    .wkbf use the binary WKB feature container, others GeoJSON\n"
+            << "  --profile FILE    Write per-feature timings, attempts and run-wide percentiles\n"
+            << "                    to FILE as JSON\n"
+            << "  --quiet           Only print the summary counts and warnings\n"
+            << "  --verbose         Also print every per-feature diagnostic (names, thresholds tried)\n"
+            << "  --log FILE        Write per-feature diagnostics to FILE, one JSON object per line\n"
+            << "  --eapply NAME     Only process features with this eapply value (repeatable)\n"
+            << "  --eapply-file FILE  Same, for every non-empty line of FILE\n"
+            << "  --borough B       Only process features in borough B: B, M, Q, R, X or a name (repeatable)\n"
+            << "  --bbox BOX        Only process features whose envelope intersects\n"
+            << "                    BOX = min_lon,min_lat,max_lon,max_lat (repeatable)\n"
+            << "  --shard I/N[:KEY] Only process shard I of N, by a hash of every feature's :id (KEY = id,\n"
+            << "                    default) or of its 0.05 degree tile (KEY = tile), into outputs named\n"
+            << "                    e.g. 1a_parks_concave_hulls.shard-I-of-N.geojson, plus a .index file\n"
+            << "  merge --shards N  Combine the N shard outputs of each output path into that path, in the\n"
+            << "                    order of a single run\n"
+            << "  --keep-unselected Copy unselected features to the outputs unchanged instead of\n"
+            << "                    leaving them out\n"
+            << "  --simplify MODE   Simplify hull inputs first (topology-preserving): 'threshold[:F]'\n"
+            << "                    uses F times the first hull threshold as tolerance (default F = 0.1),\n"
+            << "                    'budget:N' the smallest tolerance that leaves at most N vertices\n"
+            << "  --simplify-check  Also compute every hull without simplification and report\n"
+            << "                    the Hausdorff distance between the two\n"
+            << "  --snap GRID       Snap hull inputs to a precision grid of GRID meters first\n"
+            << "                    (e.g. 0.01), so near-coincident vertices can't fail the hull\n"
+            << "  --snap-check      Also run every search unsnapped and report the failed attempts\n"
+            << "                    and attempts snapping saved\n"
+            << "  --hierarchical N[:K]\n"
+            << "                    Hull features of N+ parts cluster by cluster (at most K parts\n"
+            << "                    each, default 32), then hull the merged cluster hulls\n"
+            << "  --hierarchical-check\n"
+            << "                    Also compute those hulls directly and compare area and shape\n"
+            << "  --projection P    'degrees' (default) uses one meters-per-degree constant,\n"
+            << "                    'utm18n' computes hulls and tiny-polygon areas in UTM 18N meters\n"
+            << "  --arena           Serve each feature's allocations from a per-worker arena that is\n"
+            << "                    reset after the feature, instead of the shared heap\n"
+            << "  --serve           Load the input once and answer hull requests for single features,\n"
+            << "                    one JSON object per line on stdin/stdout (see README)\n"
+            << "  --socket PATH     With --serve, listen on a Unix socket at PATH instead\n"
+            << "  --previous PATH   Reuse the hulls of an earlier original + concave hull output for\n"
+            << "                    features whose :id and geometry are unchanged\n"
+            << "  --stage STAGE     'hull' (default) reads the 0c output, 'augment' also computes the\n"
+            << "                    0c_basic_augment.py fields itself and reads the 0b output\n"
+            << "  --output-analysis PATH\n"
+            << "                    Also write the original + concave hull output with the\n"
+            << "                    2a_concave_hull_analysis.py shape metrics of every hull to PATH\n"
+            << "  --sweep AXIS=V1,V2,...\n"
+            << "                    Compute the hulls for every combination of AXIS values instead,\n"
+            << "                    AXIS = threshold (initial meters), tight or holes (yes|no); one\n"
+            << "                    concave hulls output per combination, named after it (repeatable)\n"
+            << "  --raw-properties  Only parse the input properties the stage reads and copy the others\n"
+            << "                    to the outputs as they are written in the input (GeoJSON only)\n"
+            << "  --time-budget SECONDS\n"
+            << "                    Stop a feature's hull search after SECONDS and keep the best hull\n"
+            << "                    so far, or its convex hull if no attempt finished\n"
+            << "  --queue-depth N   Features in flight between reading the input and writing the\n"
+            << "                    outputs (default 4 per thread)" << std::endl;
+}
+
+/* `value` of the search option called `option` */
+SearchStrategy parseSearchStrategy(const std::string &value, const std::string &option)
+{
+  if (value == "linear")
+  {
+    return SearchStrategy::Linear;
+  }
+  if (value == "bisect")
+  {
+    return SearchStrategy::Bisect;
+  }
+  throw std::runtime_error("Invalid value for " + option + ": " + value);
+}
+
+/* Whether `value` of the projection option called `option` selects UTM 18N */
+bool parseProjection(const std::string &value, const std::string &option)
+{
+  if (value == "degrees")
+  {
+    return false;
+  }
+  if (value == "utm18n")
+  {
+    return true;
+  }
+  throw std::runtime_error("Invalid value for " + option + ": " + value);
+}
+
+Options parseArguments(int argc, char **argv)
+{
+  Options options;
+  int first = 1;
+  if (argc > 1 && std::string(argv[1]) == "merge")
+  {
+    options.merge = true;
+    first = 2;
+  }
+  for (int i = first; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--threads" && i + 1 < argc)
+    {
+      std::string value = argv[++i];
+      if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+      {
+        throw std::runtime_error("Invalid value for --threads: " + value);
+      }
+      options.threads = static_cast<unsigned>(std::stoul(value));
+    }
+    else if (arg == "--search" && i + 1 < argc)
+    {
+      options.search = parseSearchStrategy(argv[++i], arg);
+    }
+    else if (arg == "--cache-dir" && i + 1 < argc)
+    {
+      options.cache_dir = argv[++i];
+    }
+    else if (arg == "--input" && i + 1 < argc)
+    {
+      options.input = argv[++i];
+    }
+    else if (arg == "--output-hulls" && i + 1 < argc)
+    {
+      options.output_hulls = argv[++i];
+    }
+    else if (arg == "--output-with-hulls" && i + 1 < argc)
+    {
+      options.output_with_hulls = argv[++i];
+    }
+    else if (arg == "--output-analysis" && i + 1 < argc)
+    {
+      options.output_analysis = argv[++i];
+    }
+    else if (arg == "--profile" && i + 1 < argc)
+    {
+      options.profile_path = argv[++i];
+    }
+    else if (arg == "--quiet" || arg == "-q")
+    {
+      options.log_level = LogLevel::Quiet;
+    }
+    else if (arg == "--verbose" || arg == "-v")
+    {
+      options.log_level = LogLevel::Verbose;
+    }
+    else if (arg == "--log" && i + 1 < argc)
+    {
+      options.log_path = argv[++i];
+    }
+    else if (arg == "--eapply" && i + 1 < argc)
+    {
+      options.selection.names.insert(argv[++i]);
+    }
+    else if (arg == "--eapply-file" && i + 1 < argc)
+    {
+      loadNameList(argv[++i], options.selection.names);
+    }
+    else if (arg == "--borough" && i + 1 < argc)
+    {
+      options.selection.boroughs.insert(parseBorough(argv[++i]));
+    }
+    else if (arg == "--bbox" && i + 1 < argc)
+    {
+      options.selection.bboxes.push_back(parseBoundingBox(argv[++i]));
+    }
+    else if (arg == "--shard" && i + 1 < argc)
+    {
+      options.selection.shard = parseShardSpec(argv[++i]);
+    }
+    else if (arg == "--shards" && i + 1 < argc)
+    {
+      std::string value = argv[++i];
+      if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || std::stoul(value) < 2)
+      {
+        throw std::runtime_error("Invalid value for --shards: " + value);
+      }
+      options.merge_shards = std::stoul(value);
+    }
+    else if (arg == "--keep-unselected")
+    {
+      options.keep_unselected = true;
+    }
+    else if (arg == "--simplify" && i + 1 < argc)
+    {
+      options.simplify = parseSimplifySettings(argv[++i]);
+    }
+    else if (arg == "--simplify-check")
+    {
+      options.simplify_check = true;
+    }
+    else if (arg == "--snap" && i + 1 < argc)
+    {
+      options.snap = parseSnapSettings(argv[++i]);
+    }
+    else if (arg == "--snap-check")
+    {
+      options.snap_check = true;
+    }
+    else if (arg == "--hierarchical" && i + 1 < argc)
+    {
+      options.hierarchical = parseHierarchySettings(argv[++i]);
+    }
+    else if (arg == "--hierarchical-check")
+    {
+      options.hierarchical_check = true;
+    }
+    else if (arg == "--arena")
+    {
+#ifdef NO_FEATURE_ARENA
+      throw std::runtime_error("--arena is not available in this build (built with NO_FEATURE_ARENA)");
+#else
+      options.arena = true;
+#endif
+    }
+    else if (arg == "--projection" && i + 1 < argc)
+    {
+      options.project_utm = parseProjection(argv[++i], arg);
+    }
+    else if (arg == "--stage" && i + 1 < argc)
+    {
+      std::string value = argv[++i];
+      if (value == "hull")
+      {
+        options.augment = false;
+      }
+      else if (value == "augment")
+      {
+        options.augment = true;
+      }
+      else
+      {
+        throw std::runtime_error("Invalid value for --stage: " + value);
+      }
+    }
+    else if (arg == "--previous" && i + 1 < argc)
+    {
+      options.previous_path = argv[++i];
+    }
+    else if (arg == "--sweep" && i + 1 < argc)
+    {
+      parseSweepAxis(argv[++i], options.sweep);
+    }
+    else if (arg == "--raw-properties")
+    {
+      options.raw_properties = true;
+    }
+    else if (arg == "--queue-depth" && i + 1 < argc)
+    {
+      std::string value = argv[++i];
+      if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || std::stoul(value) == 0)
+      {
+        throw std::runtime_error("Invalid value for --queue-depth: " + value);
+      }
+      options.queue_depth = std::stoul(value);
+    }
+    else if (arg == "--time-budget" && i + 1 < argc)
+    {
+      std::string value = argv[++i];
+      char *end = nullptr;
+      options.time_budget_s = std::strtod(value.c_str(), &end);
+      if (value.empty() || *end != '\0' || !(options.time_budget_s > 0.0))
+      {
+        throw std::runtime_error("Invalid value for --time-budget: " + value);
+      }
+    }
+    else if (arg == "--serve")
+    {
+      options.serve = true;
+    }
+    else if (arg == "--socket" && i + 1 < argc)
+    {
+      options.serve = true;
+      options.socket_path = argv[++i];
+    }
+    else if (arg == "--help" || arg == "-h")
+    {
+      printUsage(argv[0]);
+      std::exit(0);
+    }
+    else
+    {
+      throw std::runtime_error("Unknown argument: " + arg);
+    }
+  }
+
+  if (!options.sweep.empty() && (options.serve || options.augment || !options.previous_path.empty() ||
+                                  !options.output_analysis.empty()))
+  {
+    throw std::runtime_error("--sweep only writes concave hulls outputs; it can't be combined with --serve, "
+                             "--stage augment, --previous or --output-analysis");
+  }
+  if (options.merge != (options.merge_shards > 0))
+  {
+    throw std::runtime_error(options.merge ? "merge needs --shards N" : "--shards only applies to merge");
+  }
+  if (options.merge && options.selection.shard.enabled())
+  {
+    throw std::runtime_error("merge reads every shard; --shard doesn't apply to it");
+  }
+  if (options.selection.shard.enabled() && (options.serve || !options.sweep.empty()))
+  {
+    throw std::runtime_error("--shard can't be combined with --serve or --sweep");
+  }
+  if (options.selection.shard.enabled())
+  {
+    /* Every shard writes its own files, and merge finds them by the same names */
+    options.output_hulls = shardOutputPath(options.output_hulls, options.selection.shard);
+    options.output_with_hulls = shardOutputPath(options.output_with_hulls, options.selection.shard);
+    if (!options.output_analysis.empty())
+    {
+      options.output_analysis = shardOutputPath(options.output_analysis, options.selection.shard);
+    }
+  }
+  if (options.snap_check && !options.snap.enabled())
+  {
+    throw std::runtime_error("--snap-check needs --snap");
+  }
+  if (options.hierarchical_check && !options.hierarchical.enabled())
+  {
+    throw std::runtime_error("--hierarchical-check needs --hierarchical");
+  }
+  if (options.threads == 0)
+  {
+    options.threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if (options.input.empty())
+  {
+    options.input = options.augment ? AUGMENT_SOURCE_DATA_FILE : SOURCE_DATA_FILE;
+  }
+  options.hulls_format = featureFormatForPath(options.output_hulls);
+  options.with_hulls_format = featureFormatForPath(options.output_with_hulls);
+  options.analysis_format = featureFormatForPath(options.output_analysis);
+  if (options.raw_properties &&
+      (featureFormatForPath(options.input) != FeatureFormat::GeoJSON || options.hulls_format != FeatureFormat::GeoJSON ||
+       options.with_hulls_format != FeatureFormat::GeoJSON ||
+       (!options.output_analysis.empty() && options.analysis_format != FeatureFormat::GeoJSON)))
+  {
+    throw std::runtime_error("--raw-properties needs GeoJSON input and outputs");
+  }
+  return options;
+}
+
+/* The input properties the stage reads; --raw-properties passes the others through as text */
+const std::vector<std::string> STAGE_PROPERTY_KEYS = {":id", "eapply", "name311", "area_sqm"};
+
+/* Set up an input decoder of a worker for `options` */
+void configureDecoder(FeatureDecoder &decoder, const Options &options)
+{
+  if (options.raw_properties)
+  {
+    decoder.passThroughProperties(STAGE_PROPERTY_KEYS);
+  }
+}
+
+/* Outputs of a single input feature, filled in by a worker and consumed in input order */
+struct FeatureResult
+{
+  std::string hull_record;      // Encoded feature for the concave hulls output
+  std::string with_hull_record; // Encoded feature for the original + concave hull property output
+  std::string analysis_record;  // Encoded feature for --output-analysis
+  std::string log;              // Per-feature diagnostics (verbose console output and --log only)
+  std::string notice;           // Shown at the normal log level: hulls that needed several attempts
+  std::string cleanup_log;      // Tiny polygon removal messages, printed after processing
+  bool skipped = false;         // Not selected
+  bool omitted = false;         // Not selected and left out of the outputs (never decoded)
+  bool hulled = false;          // MultiPolygon replaced by its concave hull
+  bool cache_hit = false;       // Hull came from the hull cache
+  bool reused = false;          // Hull came from the --previous output
+  bool tiny_removed = false;    // Tiny polygons were dropped from the hull
+  int tiny_parts_removed = 0;   // How many
+  bool has_issue = false;       // Hull still has multiple polygons
+  std::string issue_name;
+  std::string issue_json; // Single-feature GeoJSON collection for temp/issue_geojson
+  FeatureProfile profile;
+  std::exception_ptr error;
+  bool done = false;
+};
+
+/*
+ * Check a hull output geometry for MultiPolygons with more than one polygon.
+ * Every tiny polygon is dropped, except for the largest polygon of all: if
+ * one polygon is left it is returned in place of the MultiPolygon, anything
+ * more is recorded as an issue (without the tiny polygons, built into
+ * `cleaned`). Areas are measured on `area_geom`, the same geometry in
+ * (possibly projected) units of `sq_meters_per_unit`.
+ */
+const Geometry *checkRemainingPolygons(const Geometry *geom, const Geometry *area_geom, double sq_meters_per_unit,
+                                       const std::map<std::string, GeoJSONValue> &properties,
+                                       std::unique_ptr<Geometry> &cleaned, FeatureResult &result)
+{
+  if (!geom || geom->getGeometryTypeId() != GEOS_MULTIPOLYGON)
+  {
+    return geom;
+  }
+  const MultiPolygon *mp = dynamic_cast<const MultiPolygon *>(geom);
+  if (!mp || mp->getNumGeometries() <= 1)
+  {
+    return geom;
+  }
+
+  /* Find the eapply value for this feature */
+  auto eapply_it = properties.find("eapply");
+  std::string eapply_name;
+  if (eapply_it != properties.end() && eapply_it->second.isString())
+  {
+    eapply_name = eapply_it->second.getString();
+  }
+  else
+  {
+    eapply_name = "(no eapply value)";
+  }
+
+  /* All part areas in one pass over the flattened rings */
+  FlatPolygons flat = flattenPolygons(*area_geom);
+  std::vector<double> areas;
+  double largest_area = 0.0;
+  for (size_t i = 0; i < flat.polygonCount(); ++i)
+  {
+    areas.push_back(polygonArea(flat, i));
+    largest_area = std::max(largest_area, areas.back());
+  }
+
+  /* Polygons smaller than the largest one and under the threshold go */
+  double tiny_area = TINY_POLYGON_AREA_THRESHOLD_SQ_METERS / sq_meters_per_unit;
+  std::vector<const Geometry *> kept;
+  std::ostringstream message;
+  for (size_t i = 0; i < areas.size(); ++i)
+  {
+    if (areas[i] < tiny_area && areas[i] < largest_area)
+    {
+      double area_sqm = areas[i] * sq_meters_per_unit;
+      message << "  ✓ " << eapply_name << ": Removed tiny polygon ("
+              << (int)area_sqm << " sq m)" << std::endl;
+      result.tiny_parts_removed++;
+    }
+    else
+    {
+      kept.push_back(mp->getGeometryN(i));
+    }
+  }
+  if (result.tiny_parts_removed > 0)
+  {
+    result.cleanup_log = message.str();
+    result.tiny_removed = true;
+  }
+  if (kept.size() == 1)
+  {
+    return kept.front();
+  }
+
+  /* Still several polygons, add to problematic list */
+  if (result.tiny_removed)
+  {
+    std::vector<std::unique_ptr<Geometry>> parts;
+    for (const Geometry *part : kept)
+    {
+      parts.push_back(part->clone());
+    }
+    cleaned = geom->getFactory()->createMultiPolygon(std::move(parts));
+    geom = cleaned.get();
+  }
+  result.has_issue = true;
+  result.issue_name = eapply_name;
+  return geom;
+}
+
+/*
+ * Compute the outputs for one feature and serialize them. All geometries
+ * created here belong to `factory`, which is owned by the calling worker,
+ * and they are destroyed on that worker too. Both outputs are encoded
+ * straight from the parsed geometry and the hull, so nothing is cloned, and
+ * GeoJSON text is only produced for outputs that are GeoJSON.
+ */
+void processFeature(const GeoJSONFeature &feature, std::string_view raw_properties, bool selected,
+                    const Options &options, const HullCache *cache, const PreviousOutput *previous,
+                    FeatureResult &result)
+{
+  /* Diagnostics are only formatted when someone will read them */
+  std::ostringstream diagnostics;
+  std::ostream null_log(nullptr);
+  bool keep_diagnostics = options.log_level == LogLevel::Verbose || !options.log_path.empty();
+  std::ostream &log = keep_diagnostics ? diagnostics : null_log;
+  const Geometry *geom = feature.getGeometry();
+  const auto &properties = feature.getProperties();
+
+  std::unique_ptr<Geometry> hull;           // Owned hull, if one is computed
+  std::unique_ptr<Geometry> hull_in_meters; // The hull before projecting back (--projection utm18n)
+  const Geometry *hull_geom = geom;         // Geometry of the concave hulls output
+  std::vector<RawProperty> hull_extras;     // Added to the concave hulls output
+  std::vector<RawProperty> original_extras; // Added to the original + concave hull output
+  std::string hull_geojson;
+  GeoJSONWriter writer;
+  std::chrono::steady_clock::time_point serialize_start;
+  bool hulls_geojson = options.hulls_format == FeatureFormat::GeoJSON;
+  bool with_hulls_geojson = options.with_hulls_format == FeatureFormat::GeoJSON;
+  bool analysis = !options.output_analysis.empty();
+  bool analysis_geojson = analysis && options.analysis_format == FeatureFormat::GeoJSON;
+  bool any_geojson = hulls_geojson || with_hulls_geojson || analysis_geojson;
+
+  FeatureProfile &profile = result.profile;
+  auto id_it = properties.find(":id");
+  if (id_it != properties.end() && id_it->second.isString())
+  {
+    profile.id = id_it->second.getString();
+  }
+  auto name_it = properties.find("eapply");
+  if (name_it != properties.end() && name_it->second.isString())
+  {
+    profile.name = name_it->second.getString();
+  }
+  if (geom)
+  {
+    profile.vertices = geom->getNumPoints();
+    profile.polygons = geom->getNumGeometries();
+  }
+
+  /* The input in UTM 18N, projected on first use and shared by --stage augment and --projection utm18n */
+  std::unique_ptr<Geometry> projected_geom;
+  auto projected = [&]() -> const Geometry *
+  {
+    if (!projected_geom)
+    {
+      auto project_start = std::chrono::steady_clock::now();
+      projected_geom = projectGeometry(*geom, TransverseMercator::utm18n(), true);
+      profile.project_ms += millisecondsSince(project_start);
+    }
+    return projected_geom.get();
+  };
+
+  /* The 0c fields go into both outputs, hulled or not */
+  AugmentMetrics augmented;
+  if (options.augment && selected && geom)
+  {
+    const Geometry *geom_utm = projected();
+    auto augment_start = std::chrono::steady_clock::now();
+    augmented = computeAugmentMetrics(*geom, *geom_utm, any_geojson);
+    hull_extras = augmented.properties;
+    original_extras = augmented.properties;
+    profile.augment_ms = millisecondsSince(augment_start);
+  }
+
+  if (!selected)
+  {
+    /* Keep unselected features in both outputs as-is (--keep-unselected) */
+    result.skipped = true;
+  }
+  else if (geom && geom->getGeometryTypeId() == GEOS_MULTIPOLYGON)
+  {
+    auto name311_it = properties.find("name311");
+    if (name311_it != properties.end() && name311_it->second.isString())
+    {
+      log << "Name: " << name311_it->second.getString() << "\n";
+    }
+    else
+    {
+      log << "Name: (no name311 value)\n";
+    }
+
+    /* Compute concave hull with adaptive threshold, unless an earlier run already did */
+    HullParameters params = hullParametersInMeters(options.threshold_m, options.increment_m, options.max_attempts,
+                                                   options.project_utm);
+    HullSearchResult search; // Hull in the units of `params`
+    std::string cache_key;
+    CachedHull cached;
+    PreviousHull reused; // Already in output coordinates
+    bool hierarchical = options.hierarchical.appliesTo(geom);
+    std::string variant = hullCacheVariant(options, hierarchical);
+    if (cache)
+    {
+      cache_key = HullCache::key(geom, params, options.search, variant);
+    }
+    std::string settings = HullCache::settingsKey(params, options.search, variant);
+    if (previous && !profile.id.empty() && previous->find(profile.id, *geom, settings, *geom->getFactory(), reused))
+    {
+      result.reused = true;
+      log << "Unchanged since the previous output (threshold: " << reused.threshold_m << " meters)\n";
+    }
+    else if (cache && cache->load(cache_key, *geom->getFactory(), cached))
+    {
+      search.hull = std::move(cached.hull);
+      search.step = cached.step;
+      search.attempts = cached.attempts;
+      result.cache_hit = true;
+      log << "Cached hull (threshold: " << options.threshold_m + search.step * options.increment_m << " meters)\n";
+    }
+    else
+    {
+      /* Project the input once; the hull is projected back below */
+      const Geometry *search_input = options.project_utm ? projected() : geom;
+
+      auto snap_start = std::chrono::steady_clock::now();
+      SnappedInput snapped = snapForHull(search_input, options.snap, params);
+      const Geometry *snapped_input = snapped.geometry ? snapped.geometry.get() : search_input;
+      profile.snap_ms = millisecondsSince(snap_start);
+      if (snapped.geometry)
+      {
+        log << "Snapped to a " << options.snap.grid_m << " meter grid (" << snapped.vertices_before << " -> "
+            << snapped.vertices_after << " vertices)\n";
+      }
+
+      auto simplify_start = std::chrono::steady_clock::now();
+      SimplifiedInput simplified = simplifyForHull(snapped_input, options.simplify, params);
+      const Geometry *hull_input = simplified.geometry ? simplified.geometry.get() : snapped_input;
+      profile.simplify_ms = millisecondsSince(simplify_start);
+      profile.hull_vertices = simplified.vertices_after;
+      if (simplified.geometry)
+      {
+        profile.simplify_tolerance_m = simplified.tolerance * params.meters_per_unit;
+        log << "Simplified " << simplified.vertices_before << " -> " << simplified.vertices_after
+            << " vertices (tolerance: " << profile.simplify_tolerance_m << " meters)\n";
+      }
+
+      auto bound_start = std::chrono::steady_clock::now();
+      if (hierarchical)
+      {
+        /* Clusters are hulled on this worker's share of the cores; the time budget covers the whole search */
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        if (options.time_budget_s > 0.0)
+        {
+          deadline = bound_start + timeBudget(options);
+        }
+        unsigned cluster_threads = std::max(1u, std::thread::hardware_concurrency() / std::max(1u, options.threads));
+        HierarchicalSearch hierarchy = hierarchicalHullSearch(hull_input, params, options.search,
+                                                              options.hierarchical, cluster_threads, deadline, log);
+        search = std::move(hierarchy.result);
+        profile.clusters = hierarchy.clusters;
+        profile.hierarchical_ms = millisecondsSince(bound_start);
+      }
+      else
+      {
+        HullEngine engine(hull_input, params);
+        profile.bound_ms = millisecondsSince(bound_start);
+        if (options.time_budget_s > 0.0)
+        {
+          engine.setDeadline(bound_start + timeBudget(options));
+        }
+        search = engine.search(options.search, log);
+      }
+      profile.triangulation_ms = search.triangulation_seconds * 1000.0;
+      profile.hull_ms = search.hull_seconds * 1000.0;
+      if (cache && !search.timed_out)
+      {
+        cache->store(cache_key, search);
+      }
+
+      if (options.simplify_check && simplified.geometry && search.hull)
+      {
+        /* Reference hull of the unsimplified input; its log is not interesting */
+        std::ostream null_reference_log(nullptr);
+        HullSearchResult reference = HullEngine(snapped_input, params).search(options.search, null_reference_log);
+        if (reference.hull)
+        {
+          /* Converted with the same constant as the thresholds */
+          profile.hausdorff_m = geos::algorithm::distance::DiscreteHausdorffDistance::distance(
+                                    *search.hull, *reference.hull) *
+                                params.meters_per_unit;
+          log << "Hausdorff distance to the unsimplified hull: " << profile.hausdorff_m << " meters (step "
+              << search.step << " vs " << reference.step << ")\n";
+        }
+      }
+
+      if (options.hierarchical_check && profile.clusters > 1 && search.hull)
+      {
+        /* The direct hull of the same input */
+        std::ostream null_reference_log(nullptr);
+        auto direct_start = std::chrono::steady_clock::now();
+        HullSearchResult direct = HullEngine(hull_input, params).search(options.search, null_reference_log);
+        profile.direct_ms = millisecondsSince(direct_start);
+        if (direct.hull)
+        {
+          try
+          {
+            HullComparison comparison = compareHulls(*search.hull, *direct.hull, params.meters_per_unit);
+            profile.direct_area_ratio = comparison.area_ratio;
+            profile.direct_iou = comparison.iou;
+            profile.direct_hausdorff_m = comparison.hausdorff_m;
+            log << "Direct hull: " << profile.direct_ms << " ms (hierarchical: " << profile.hierarchical_ms
+                << " ms), area ratio " << comparison.area_ratio << ", IoU " << comparison.iou
+                << ", Hausdorff distance " << comparison.hausdorff_m << " meters\n";
+          }
+          catch (const std::exception &e)
+          {
+            log << "Could not compare with the direct hull: " << e.what() << "\n";
+          }
+        }
+      }
+
+      if (options.snap_check && snapped.geometry)
+      {
+        /* The same search on the unsnapped input, simplified alike */
+        std::ostream null_reference_log(nullptr);
+        SimplifiedInput unsnapped = simplifyForHull(search_input, options.simplify, params);
+        HullSearchResult reference =
+            HullEngine(unsnapped.geometry ? unsnapped.geometry.get() : search_input, params)
+                .search(options.search, null_reference_log);
+        profile.unsnapped_attempts = reference.attempts;
+        profile.unsnapped_failed_attempts = reference.failed_attempts;
+        log << "Unsnapped input: " << reference.attempts << " attempt(s), " << reference.failed_attempts
+            << " failed (snapped: " << search.attempts << ", " << search.failed_attempts << " failed)\n";
+      }
+    }
+    if (result.reused)
+    {
+      hull = std::move(reused.hull);
+      if (options.project_utm)
+      {
+        hull_in_meters = projectGeometry(*hull, TransverseMercator::utm18n(), true);
+      }
+    }
+    else if (options.project_utm && search.hull)
+    {
+      /* Keep the projected hull for the tiny polygon areas */
+      hull_in_meters = std::move(search.hull);
+      hull = projectGeometry(*hull_in_meters, TransverseMercator::utm18n(), false);
+    }
+    else
+    {
+      hull = std::move(search.hull);
+    }
+    hull_geom = hull.get();
+    double threshold_meters = result.reused ? reused.threshold_m : options.threshold_m + search.step * options.increment_m;
+    if (search.convex_fallback)
+    {
+      threshold_meters = std::numeric_limits<double>::quiet_NaN(); // No threshold produced it; written as null
+    }
+    profile.hulled = true;
+    profile.cache_hit = result.cache_hit;
+    profile.reused = result.reused;
+    profile.attempts = search.attempts;
+    profile.failed_attempts = search.failed_attempts;
+    profile.skipped_steps = search.skipped_steps;
+    profile.threshold_m = threshold_meters;
+    profile.timed_out = search.timed_out;
+    profile.convex_hull = search.convex_fallback;
+
+    /* Log if multiple attempts were needed, or the time ran out */
+    if ((search.step > 0 || search.timed_out) && !result.cache_hit)
+    {
+      auto eapply_it = properties.find("eapply");
+      std::string park_name = "(unknown)";
+      if (eapply_it != properties.end() && eapply_it->second.isString())
+      {
+        park_name = eapply_it->second.getString();
+      }
+
+      std::ostringstream notice;
+      if (search.convex_fallback)
+      {
+        notice << "  ⏱ " << park_name << " ran out of time after " << search.attempts
+               << " attempts (convex hull)\n";
+      }
+      else if (search.timed_out)
+      {
+        notice << "  ⏱ " << park_name << " ran out of time after " << search.attempts
+               << " attempts (best threshold: " << (int)threshold_meters << "m)\n";
+      }
+      else
+      {
+        notice << "  ⚡ " << park_name << " required " << search.attempts
+               << " attempts (threshold: " << (int)threshold_meters << "m)\n";
+      }
+      result.notice = notice.str();
+    }
+
+    /* Record the threshold that produced the hull */
+    RawProperty threshold_property{"concave_hull_threshold_m", propertyValueJson(GeoJSONValue(threshold_meters))};
+    hull_extras.push_back(threshold_property);
+    original_extras.push_back(threshold_property);
+    if (options.time_budget_s > 0.0)
+    {
+      /* How a hull cut short by the time budget was chosen (null = complete search) */
+      std::string fallback = search.convex_fallback ? "\"convex_hull\"" : search.timed_out ? "\"best_so_far\"" : "null";
+      RawProperty fallback_property{"concave_hull_fallback", fallback};
+      hull_extras.push_back(fallback_property);
+      original_extras.push_back(fallback_property);
+    }
+    /* What --previous matches on; a hull cut short by the time budget isn't worth reusing */
+    original_extras.push_back(
+        {"concave_hull_settings", search.timed_out ? "null" : propertyValueJson(GeoJSONValue(settings))});
+
+    /* Serialize concave hull to GeoJSON once: it is the first output's geometry and the second's property */
+    serialize_start = std::chrono::steady_clock::now();
+    if (any_geojson)
+    {
+      hull_geojson = writer.write(hull.get());
+    }
+    original_extras.push_back({"concave_hull_polygon", with_hulls_geojson || analysis_geojson ? geometryPropertyJson(hull_geojson) : std::string(), hull.get()});
+    profile.serialize_ms += millisecondsSince(serialize_start);
+    result.hulled = true;
+  }
+
+  /* Non-MultiPolygon features are kept as-is in both outputs (no concave hull property) */
+  std::unique_ptr<Geometry> cleaned_hull; // Hull without its tiny polygons, if it still has several
+  const Geometry *written_geom =
+      hull_in_meters
+          ? checkRemainingPolygons(hull_geom, hull_in_meters.get(), 1.0, properties, cleaned_hull, result)
+          : checkRemainingPolygons(hull_geom, hull_geom, SQ_METERS_PER_SQ_DEGREE, properties, cleaned_hull, result);
+
+  serialize_start = std::chrono::steady_clock::now();
+  std::string written_geom_json; // GeoJSON output and issue files only
+  if (hulls_geojson || result.has_issue)
+  {
+    written_geom_json = hull && written_geom == hull.get() && !hull_geojson.empty() ? std::move(hull_geojson) : writer.write(written_geom);
+  }
+  result.hull_record = encodeFeature(options.hulls_format, written_geom, written_geom_json, properties, hull_extras, feature.getId(),
+                                     raw_properties);
+  std::string original_geom_json;
+  if ((with_hulls_geojson && !options.hulls_only) || analysis_geojson)
+  {
+    original_geom_json = written_geom == geom && !written_geom_json.empty() ? written_geom_json : writer.write(geom);
+  }
+  if (options.hulls_only)
+  {
+    /* Nobody reads the second output */
+  }
+  else if (!result.hulled && written_geom == geom && options.hulls_format == options.with_hulls_format)
+  {
+    /* Both outputs are the unchanged input feature */
+    result.with_hull_record = result.hull_record;
+  }
+  else
+  {
+    result.with_hull_record = encodeFeature(options.with_hulls_format, geom, original_geom_json, properties, original_extras, feature.getId(),
+                                            raw_properties);
+  }
+  profile.serialize_ms += millisecondsSince(serialize_start);
+
+  if (analysis)
+  {
+    /* The 2a metrics of the full hull (before tiny polygon cleanup, like concave_hull_polygon) */
+    auto analysis_start = std::chrono::steady_clock::now();
+    std::vector<RawProperty> analysis_extras = original_extras;
+    if (result.hulled && hull)
+    {
+      std::unique_ptr<Geometry> projected_hull;
+      const Geometry *hull_utm = hull_in_meters.get();
+      if (!hull_utm)
+      {
+        projected_hull = projectGeometry(*hull, TransverseMercator::utm18n(), true);
+        hull_utm = projected_hull.get();
+      }
+      double original_area_sqm = std::numeric_limits<double>::quiet_NaN();
+      auto area_it = properties.find("area_sqm");
+      if (augmented.convex_hull)
+      {
+        original_area_sqm = augmented.area_sqm;
+      }
+      else if (area_it != properties.end() && area_it->second.isNumber())
+      {
+        original_area_sqm = area_it->second.getNumber();
+      }
+      for (RawProperty &property : computeHullAnalysis(*hull_utm, original_area_sqm))
+      {
+        analysis_extras.push_back(std::move(property));
+      }
+    }
+    else
+    {
+      for (RawProperty &property : emptyHullAnalysis())
+      {
+        analysis_extras.push_back(std::move(property));
+      }
+    }
+    profile.analysis_ms = millisecondsSince(analysis_start);
+
+    serialize_start = std::chrono::steady_clock::now();
+    result.analysis_record = encodeFeature(options.analysis_format, geom, original_geom_json, properties, analysis_extras, feature.getId(),
+                                           raw_properties);
+  }
+  if (result.has_issue)
+  {
+    result.issue_json = singleFeatureCollectionJson(
+        hulls_geojson ? result.hull_record
+                      : encodeFeature(FeatureFormat::GeoJSON, written_geom, written_geom_json, properties, hull_extras,
+                                      feature.getId(), raw_properties));
+  }
+  profile.serialize_ms += millisecondsSince(serialize_start);
+  result.log = diagnostics.str();
+}
+
+#ifndef NO_FEATURE_ARENA
+/*
+ * Run `process` (which fills in a FeatureResult) with every allocation it
+ * makes served by `arena`, then copy the result to the heap and reset the
+ * arena. Exceptions are rethrown as heap copies of their message, since the
+ * original may keep its text in the arena; the arena is reset either way.
+ */
+template <typename Process>
+void processInArena(FeatureArena &arena, FeatureResult &result, Process process)
+{
+  ArenaStats stats;
+  {
+    /* Declared first, so the reset comes after the scope and everything allocated in it, also on a throw */
+    OnScopeExit reset_arena([&]()
+                            { stats = arena.reset(); });
+    ArenaScope scope(arena);
+    FeatureResult scratch;
+    try
+    {
+      scratch.profile = result.profile;
+      process(scratch);
+    }
+    catch (const std::exception &e)
+    {
+      ArenaPause pause;
+      throw std::runtime_error(e.what());
+    }
+    ArenaPause pause;
+    result = scratch;
+  }
+  result.profile.arena_allocations = stats.allocations;
+  result.profile.arena_peak_bytes = stats.peak_bytes;
+  result.profile.arena_overflows = stats.overflow_allocations;
+}
+#endif
+
+/*
+ * --serve: the input is decoded once and kept in memory, indexed by ":id"
+ * and eapply, and each request line recomputes the hull of one feature:
+ *
+ *   {"id": X} | {"name": X} | {"index": N}, optionally with "threshold_m",
+ *   "increment_m", "max_attempts", "search", "projection", "simplify",
+ *   "snap", "verbose" and "geometry" (GeoJSON replacing the stored geometry)
+ *   {"op": "info"} | {"op": "shutdown"}
+ *
+ * Each reply is one line, {"ok": true, ..., "feature": <concave hull
+ * feature>} or {"ok": false, "error": "..."}.
+ */
+using request_json = geos_nlohmann::json;
+using reply_json = geos_nlohmann::ordered_json;
+
+/* Positive number `key` of `request`, or `fallback` if absent */
+double requestNumber(const request_json &request, const char *key, double fallback)
+{
+  auto it = request.find(key);
+  if (it == request.end())
+  {
+    return fallback;
+  }
+  if (!it->is_number() || it->get<double>() <= 0.0)
+  {
+    throw std::runtime_error(std::string("Invalid value for ") + key + ": " + it->dump());
+  }
+  return it->get<double>();
+}
+
+/* `options` with the hull settings a request overrides */
+Options requestOptions(const request_json &request, Options options)
+{
+  options.threshold_m = static_cast<float>(requestNumber(request, "threshold_m", options.threshold_m));
+  options.increment_m = static_cast<float>(requestNumber(request, "increment_m", options.increment_m));
+  double max_attempts = requestNumber(request, "max_attempts", options.max_attempts);
+  if (max_attempts != static_cast<int>(max_attempts) || max_attempts > 100000)
+  {
+    throw std::runtime_error("Invalid value for max_attempts: " + request["max_attempts"].dump());
+  }
+  options.max_attempts = static_cast<int>(max_attempts);
+  if (request.contains("search"))
+  {
+    options.search = parseSearchStrategy(request["search"].get<std::string>(), "search");
+  }
+  if (request.contains("projection"))
+  {
+    options.project_utm = parseProjection(request["projection"].get<std::string>(), "projection");
+  }
+  if (request.contains("simplify"))
+  {
+    options.simplify = parseSimplifySettings(request["simplify"].get<std::string>());
+  }
+  if (request.contains("snap"))
+  {
+    const request_json &snap = request["snap"];
+    options.snap = parseSnapSettings(snap.is_number() ? snap.dump() : snap.get<std::string>());
+  }
+  options.log_level = request.value("verbose", false) ? LogLevel::Verbose : LogLevel::Normal;
+  options.log_path.clear();
+  options.hulls_format = FeatureFormat::GeoJSON;
+  options.hulls_only = true;
+  options.output_analysis.clear();
+  return options;
+}
+
+int runServer(const Options &options)
+{
+  auto load_start = std::chrono::steady_clock::now();
+  GeometryFactory::Ptr factory = GeometryFactory::create();
+  std::unique_ptr<FeatureReader> reader = openFeatureReader(options.input);
+  FeatureDecoder decoder(featureFormatForPath(options.input), *factory);
+  configureDecoder(decoder, options);
+
+  /* Collections own their one feature; features are looked up by position */
+  std::vector<GeoJSONFeatureCollection> features;
+  std::vector<std::string_view> raw_properties; // Spans of the input, which stays mapped
+  std::unordered_map<std::string, size_t> by_id;
+  std::unordered_map<std::string, size_t> by_name;
+  std::string_view record;
+  while (reader->next(record))
+  {
+    std::string_view raw;
+    features.push_back(decoder.decode(record, &raw));
+    raw_properties.push_back(raw);
+    const auto &properties = features.back().getFeatures().at(0).getProperties();
+    auto id_it = properties.find(":id");
+    if (id_it != properties.end() && id_it->second.isString())
+    {
+      by_id.emplace(id_it->second.getString(), features.size() - 1);
+    }
+    auto name_it = properties.find("eapply");
+    if (name_it != properties.end() && name_it->second.isString())
+    {
+      by_name.emplace(name_it->second.getString(), features.size() - 1);
+    }
+  }
+
+  std::unique_ptr<HullCache> hull_cache;
+  if (!options.cache_dir.empty())
+  {
+    hull_cache = std::make_unique<HullCache>(options.cache_dir);
+  }
+  GeoJSONReader geometry_reader(*factory);
+
+  /* Replies go to stdout, so everything else goes to stderr */
+  std::cerr << "Serving " << features.size() << " features from " << options.input << " (loaded in "
+            << (int)millisecondsSince(load_start) << " ms) on "
+            << (options.socket_path.empty() ? "stdin" : options.socket_path) << std::endl;
+
+  auto find_feature = [&](const request_json &request) -> size_t
+  {
+    if (request.contains("index"))
+    {
+      size_t index = request["index"].get<size_t>();
+      if (index >= features.size())
+      {
+        throw std::runtime_error("No feature at index " + std::to_string(index));
+      }
+      return index;
+    }
+    for (auto [key, index_of] : {std::make_pair("id", &by_id), std::make_pair("name", &by_name)})
+    {
+      if (request.contains(key))
+      {
+        std::string value = request[key].get<std::string>();
+        auto it = index_of->find(value);
+        if (it == index_of->end())
+        {
+          throw std::runtime_error(std::string("No feature with ") + key + " " + value);
+        }
+        return it->second;
+      }
+    }
+    throw std::runtime_error("Request needs an id, name or index");
+  };
+
+  LineHandler handler = [&](const std::string &line, std::string &reply)
+  {
+    reply_json response;
+    bool keep_serving = true;
+    std::string feature_json;
+    try
+    {
+      request_json request = request_json::parse(line);
+      std::string op = request.value("op", "hull");
+      if (op == "shutdown")
+      {
+        response["ok"] = true;
+        keep_serving = false;
+      }
+      else if (op == "info")
+      {
+        response["ok"] = true;
+        response["input"] = options.input;
+        response["features"] = features.size();
+        response["geos_version"] = GEOS_VERSION;
+      }
+      else if (op == "hull")
+      {
+        size_t index = find_feature(request);
+        Options request_options = requestOptions(request, options);
+        const GeoJSONFeature &stored = features[index].getFeatures().at(0);
+
+        FeatureResult result;
+        result.profile.index = index;
+        auto start = std::chrono::steady_clock::now();
+        if (request.contains("geometry"))
+        {
+          GeoJSONFeature edited(geometry_reader.read(request["geometry"].dump()), stored.getProperties(),
+                                stored.getId());
+          processFeature(edited, raw_properties[index], true, request_options, hull_cache.get(), nullptr, result);
+        }
+        else
+        {
+          processFeature(stored, raw_properties[index], true, request_options, hull_cache.get(), nullptr, result);
+        }
+
+        const FeatureProfile &profile = result.profile;
+        response["ok"] = true;
+        response["index"] = index;
+        response["id"] = profile.id;
+        response["name"] = profile.name;
+        response["hulled"] = profile.hulled;
+        response["cache_hit"] = profile.cache_hit;
+        response["attempts"] = profile.attempts;
+        response["threshold_m"] = profile.threshold_m;
+        response["tiny_removed"] = result.tiny_removed;
+        response["multi_polygon"] = result.has_issue;
+        response["ms"] = millisecondsSince(start);
+        if (request_options.log_level == LogLevel::Verbose)
+        {
+          response["log"] = result.log;
+        }
+        feature_json = std::move(result.hull_record);
+      }
+      else
+      {
+        throw std::runtime_error("Unknown op: " + op);
+      }
+    }
+    catch (const std::exception &e)
+    {
+      response = reply_json();
+      response["ok"] = false;
+      response["error"] = e.what();
+      feature_json.clear();
+    }
+
+    reply = response.dump(-1, ' ', false, reply_json::error_handler_t::replace);
+    if (!feature_json.empty())
+    {
+      /* The hull feature is already GeoJSON text; splice it in rather than reparse it */
+      reply.pop_back();
+      reply += ",\"feature\":";
+      reply += feature_json;
+      reply += '}';
+    }
+    return keep_serving;
+  };
+
+  if (options.socket_path.empty())
+  {
+    serveStream(std::cin, std::cout, handler);
+  }
+  else
+  {
+    auto error_reply = [](const std::string &error)
+    {
+      reply_json response;
+      response["ok"] = false;
+      response["error"] = error;
+      return response.dump();
+    };
+    serveUnixSocket(options.socket_path, handler, error_reply);
+  }
+  return 0;
+}
+
+/*
+ * --sweep: the concave hulls of every feature for every configuration of
+ * the grid, one concave hulls output per configuration. The input is read
+ * once and the work is scheduled as feature x configuration tasks in input
+ * order, so the configurations of a large park spread over the workers.
+ * Each worker keeps the feature it decoded last (and its projection) for
+ * its next task, and HullEngine's part distance bound, which doesn't depend
+ * on the search settings, is computed once per feature for all of them.
+ */
+struct SweepResult
+{
+  std::string record; // Encoded feature for the configuration's output
+  bool omitted = false;
+  bool hulled = false;
+  int tiny_parts_removed = 0;
+  bool has_issue = false;
+  int attempts = 0;
+  bool timed_out = false;
+  std::exception_ptr error;
+  bool done = false;
+};
+
+/* HullEngine's bound of one feature, computed by the first worker that needs it */
+struct SweepBound
+{
+  std::once_flag once;
+  double min_single_threshold = 0.0;
+};
+
+void sweepFeature(const GeoJSONFeature &feature, std::string_view raw_properties, bool selected,
+                  const Geometry *projected_geom,
+                  const SweepConfig &config, const Options &options, const HullCache *cache, SweepBound &bound,
+                  SweepResult &result)
+{
+  const Geometry *geom = feature.getGeometry();
+  const auto &properties = feature.getProperties();
+  std::unique_ptr<Geometry> hull;
+  std::unique_ptr<Geometry> hull_in_meters;
+  const Geometry *hull_geom = geom;
+  std::vector<RawProperty> extras;
+  std::ostream null_log(nullptr);
+
+  if (selected && geom && geom->getGeometryTypeId() == GEOS_MULTIPOLYGON)
+  {
+    HullParameters params = hullParametersInMeters(config.threshold_m, options.increment_m, options.max_attempts,
+                                                   options.project_utm, config.is_tight, config.is_holes_allowed);
+    const Geometry *search_input = options.project_utm ? projected_geom : geom;
+    HullSearchResult search;
+    std::string cache_key;
+    CachedHull cached;
+    if (cache)
+    {
+      /* Sweeps always search directly */
+      cache_key = HullCache::key(geom, params, options.search, hullCacheVariant(options, false));
+    }
+    if (cache && cache->load(cache_key, *geom->getFactory(), cached))
+    {
+      search.hull = std::move(cached.hull);
+      search.step = cached.step;
+      search.attempts = cached.attempts;
+    }
+    else
+    {
+      auto search_start = std::chrono::steady_clock::now();
+      auto search_within_budget = [&](HullEngine engine)
+      {
+        if (options.time_budget_s > 0.0)
+        {
+          engine.setDeadline(search_start + timeBudget(options));
+        }
+        return engine.search(options.search, null_log);
+      };
+      SnappedInput snapped = snapForHull(search_input, options.snap, params);
+      const Geometry *snapped_input = snapped.geometry ? snapped.geometry.get() : search_input;
+      SimplifiedInput simplified = simplifyForHull(snapped_input, options.simplify, params);
+      if (simplified.geometry || snapped.geometry)
+      {
+        /* The shared bound is of the unchanged input */
+        search = search_within_budget(
+            HullEngine(simplified.geometry ? simplified.geometry.get() : snapped_input, params));
+      }
+      else
+      {
+        std::call_once(bound.once, [&]()
+                       { bound.min_single_threshold = computeMinSingleThreshold(search_input); });
+        search = search_within_budget(HullEngine(search_input, params, bound.min_single_threshold));
+      }
+      if (cache && !search.timed_out)
+      {
+        cache->store(cache_key, search);
+      }
+    }
+
+    if (options.project_utm && search.hull)
+    {
+      hull_in_meters = std::move(search.hull);
+      hull = projectGeometry(*hull_in_meters, TransverseMercator::utm18n(), false);
+    }
+    else
+    {
+      hull = std::move(search.hull);
+    }
+    hull_geom = hull.get();
+    result.hulled = true;
+    result.attempts = search.attempts;
+    result.timed_out = search.timed_out;
+
+    double threshold_meters = search.convex_fallback ? std::numeric_limits<double>::quiet_NaN()
+                                                     : config.threshold_m + search.step * options.increment_m;
+    extras.push_back({"concave_hull_sweep", propertyValueJson(GeoJSONValue(config.label()))});
+    extras.push_back({"concave_hull_threshold_m", propertyValueJson(GeoJSONValue(threshold_meters))});
+    if (options.time_budget_s > 0.0)
+    {
+      extras.push_back({"concave_hull_fallback", search.convex_fallback ? "\"convex_hull\""
+                                                 : search.timed_out     ? "\"best_so_far\""
+                                                                        : "null"});
+    }
+  }
+
+  FeatureResult check;
+  std::unique_ptr<Geometry> cleaned_hull;
+  const Geometry *written_geom =
+      hull_in_meters
+          ? checkRemainingPolygons(hull_geom, hull_in_meters.get(), 1.0, properties, cleaned_hull, check)
+          : checkRemainingPolygons(hull_geom, hull_geom, SQ_METERS_PER_SQ_DEGREE, properties, cleaned_hull, check);
+  result.tiny_parts_removed = check.tiny_parts_removed;
+  result.has_issue = check.has_issue;
+
+  std::string written_geom_json;
+  if (options.hulls_format == FeatureFormat::GeoJSON)
+  {
+    GeoJSONWriter writer;
+    written_geom_json = writer.write(written_geom);
+  }
+  result.record = encodeFeature(options.hulls_format, written_geom, written_geom_json, properties, extras, feature.getId(),
+                                raw_properties);
+}
+
+int runSweep(const Options &options)
+{
+  auto run_start = std::chrono::steady_clock::now();
+  bool quiet = options.log_level == LogLevel::Quiet;
+  std::vector<SweepConfig> configs = options.sweep.configurations(options.threshold_m, HULL_PARAMETERS.is_tight,
+                                                                  HULL_PARAMETERS.is_holes_allowed);
+
+  /* Records stay valid as long as their reader */
+  FeatureFormat input_format = featureFormatForPath(options.input);
+  std::unique_ptr<FeatureReader> reader = openFeatureReader(options.input);
+  std::vector<std::string_view> records;
+  std::string_view record;
+  while (reader->next(record))
+  {
+    records.push_back(record);
+  }
+  std::unique_ptr<FeatureSelection> selection;
+  if (!options.selection.empty())
+  {
+    selection = std::make_unique<FeatureSelection>(options.input, options.selection);
+  }
+  std::unique_ptr<HullCache> hull_cache;
+  if (!options.cache_dir.empty())
+  {
+    hull_cache = std::make_unique<HullCache>(options.cache_dir);
+  }
+  if (!quiet)
+  {
+    std::cout << "Sweeping " << configs.size() << " hull configuration(s) over " << records.size() << " features of "
+              << options.input << " on " << options.threads << " thread(s)" << std::endl;
+  }
+
+  std::vector<std::unique_ptr<FeatureWriter>> outputs;
+  for (const SweepConfig &config : configs)
+  {
+    outputs.push_back(openFeatureWriter(sweepOutputPath(options.output_hulls, config)));
+  }
+
+  size_t task_count = records.size() * configs.size();
+  std::vector<SweepResult> results(task_count);
+  std::vector<SweepBound> bounds(records.size());
+  std::atomic<size_t> next_task{0};
+  std::atomic<bool> abort_workers{false};
+  std::mutex results_mutex;
+  std::condition_variable result_ready;
+
+  /* Factories as in the batch run: one per worker, since their reference counts are not synchronized */
+  auto worker = [&](const GeometryFactory &worker_factory)
+  {
+    FeatureDecoder decoder(input_format, worker_factory);
+    configureDecoder(decoder, options);
+    size_t decoded_index = records.size();
+    std::optional<GeoJSONFeatureCollection> decoded;
+    std::string_view raw_properties;
+    std::unique_ptr<Geometry> projected;
+    for (size_t task = next_task++; task < task_count && !abort_workers; task = next_task++)
+    {
+      size_t index = task / configs.size();
+      SweepResult &result = results[task];
+      bool selected = !selection || selection->contains(index);
+      try
+      {
+        if (!selected && !options.keep_unselected)
+        {
+          result.omitted = true;
+        }
+        else
+        {
+          if (index != decoded_index)
+          {
+            decoded_index = records.size();
+            projected.reset();
+            decoded.reset();
+            decoded.emplace(decoder.decode(records[index], &raw_properties));
+            decoded_index = index;
+            const Geometry *geom = decoded->getFeatures().at(0).getGeometry();
+            if (options.project_utm && selected && geom && geom->getGeometryTypeId() == GEOS_MULTIPOLYGON)
+            {
+              projected = projectGeometry(*geom, TransverseMercator::utm18n(), true);
+            }
+          }
+          sweepFeature(decoded->getFeatures().at(0), raw_properties, selected, projected.get(),
+                       configs[task % configs.size()], options, hull_cache.get(), bounds[index], result);
+        }
+      }
+      catch (...)
+      {
+        result.error = std::current_exception();
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        result.done = true;
+      }
+      result_ready.notify_all();
+    }
+  };
+
+  std::vector<GeometryFactory::Ptr> worker_factories;
+  std::vector<std::thread> workers;
+  for (unsigned w = 0; w < options.threads; ++w)
+  {
+    worker_factories.push_back(GeometryFactory::create());
+  }
+  auto join_workers = [&]()
+  {
+    for (auto &t : workers)
+    {
+      if (t.joinable())
+      {
+        t.join();
+      }
+    }
+  };
+  /* A failed feature or output write stops the remaining tasks */
+  OnScopeExit stop_workers([&]()
+                          {
+                            abort_workers = true;
+                            join_workers(); });
+  for (unsigned w = 0; w < options.threads; ++w)
+  {
+    workers.emplace_back(worker, std::cref(*worker_factories[w]));
+  }
+
+  /* Per configuration: hulls, attempts, tiny polygons removed, features still MultiPolygons */
+  std::vector<int> hulls(configs.size(), 0);
+  std::vector<long> attempts(configs.size(), 0);
+  std::vector<int> tiny_removed(configs.size(), 0);
+  std::vector<int> issues(configs.size(), 0);
+  std::vector<int> timed_out(configs.size(), 0);
+  for (size_t task = 0; task < task_count; ++task)
+  {
+    SweepResult &result = results[task];
+    {
+      std::unique_lock<std::mutex> lock(results_mutex);
+      result_ready.wait(lock, [&]
+                        { return result.done; });
+    }
+    if (result.error)
+    {
+      std::rethrow_exception(result.error);
+    }
 
-const float METERS_PER_DEGREE = 111319.9;
-const float CONCAVE_HULL_LENGTH_THRESHOLD_METERS = 50.0;
-const float CONCAVE_HULL_LENGTH_THRESHOLD = CONCAVE_HULL_LENGTH_THRESHOLD_METERS / METERS_PER_DEGREE;
-const float CONCAVE_HULL_LENGTH_INCREMENT_METERS = 20.0;
-const float CONCAVE_HULL_LENGTH_INCREMENT = CONCAVE_HULL_LENGTH_INCREMENT_METERS / METERS_PER_DEGREE;
-const int MAX_ATTEMPTS = 100; // Maximum number of threshold increments to try
+    size_t c = task % configs.size();
+    if (!result.omitted)
+    {
+      outputs[c]->write(result.record);
+    }
+    hulls[c] += result.hulled;
+    attempts[c] += result.attempts;
+    tiny_removed[c] += result.tiny_parts_removed;
+    issues[c] += result.has_issue;
+    timed_out[c] += result.timed_out;
+    std::string().swap(result.record);
 
-// Threshold for tiny polygon removal (in square meters)
-const double TINY_POLYGON_AREA_THRESHOLD_SQ_METERS = 500.0; // 100 square meters
-const double SQ_METERS_PER_SQ_DEGREE = METERS_PER_DEGREE * METERS_PER_DEGREE;
-const double TINY_POLYGON_AREA_THRESHOLD = TINY_POLYGON_AREA_THRESHOLD_SQ_METERS / SQ_METERS_PER_SQ_DEGREE;
+    if (!quiet && c + 1 == configs.size() && (task / configs.size() + 1) % 100 == 0)
+    {
+      std::cout << "  Processed " << task / configs.size() + 1 << " features..." << std::endl;
+    }
+  }
+  join_workers();
 
-std::string readFile(const char *filename)
-{
-  std::ifstream file(filename);
-  if (!file.is_open())
+  for (size_t c = 0; c < configs.size(); ++c)
   {
-    throw std::runtime_error(std::string("Could not open file: ") + filename);
+    outputs[c]->close();
+    std::cout << configs[c].label() << ": " << hulls[c] << " hull(s) in " << attempts[c] << " attempt(s), "
+              << tiny_removed[c] << " tiny polygon(s) removed, " << issues[c] << " still MultiPolygon(s)";
+    if (options.time_budget_s > 0.0)
+    {
+      std::cout << ", " << timed_out[c] << " out of time";
+    }
+    std::cout << "; written to: " << sweepOutputPath(options.output_hulls, configs[c])
+              << std::endl;
   }
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  return buffer.str();
+  std::cout << "Sweep completed in " << millisecondsSince(run_start) / 1000.0 << " s" << std::endl;
+  std::cout << "Peak memory usage: " << peakMemoryBytes() / (1024 * 1024) << " MB" << std::endl;
+  return 0;
 }
 
-void writeFile(const char *filename, const std::string &content)
+/*
+ * merge: combine the outputs of `--shard I/N` runs. The shard indexes are
+ * read first, so a missing or mismatched shard fails before any output is
+ * replaced.
+ */
+int runMerge(const Options &options)
 {
-  std::ofstream file(filename);
-  if (!file.is_open())
+  auto run_start = std::chrono::steady_clock::now();
+  ShardSpec spec;
+  spec.count = options.merge_shards;
+  std::vector<ShardIndex> indexes;
+  for (spec.index = 0; spec.index < spec.count; ++spec.index)
   {
-    throw std::runtime_error(std::string("Could not write to file: ") + filename);
+    indexes.push_back(readShardIndex(shardIndexPath(shardOutputPath(options.output_hulls, spec)), spec));
   }
-  file << content;
-}
 
-bool createDirectoryIfNotExists(const std::string &dir_path)
-{
-#if __cplusplus >= 201703L
-  namespace fs = std::filesystem;
-  if (!fs::exists(dir_path))
+  std::vector<std::pair<const char *, std::string>> outputs = {
+      {"Concave hulls", options.output_hulls},
+      {"Original geometries with concave hulls", options.output_with_hulls}};
+  if (!options.output_analysis.empty())
   {
-    return fs::create_directory(dir_path);
+    outputs.emplace_back("Concave hull analysis", options.output_analysis);
   }
-  return true;
-#else
-  struct stat st = {0};
-  if (stat(dir_path.c_str(), &st) == -1)
+  for (const auto &[description, path] : outputs)
   {
-    return mkdir(dir_path.c_str(), 0700) == 0;
+    size_t features = mergeShardOutputs(path, indexes);
+    std::cout << description << " of " << spec.count << " shards (" << features << " features) written to: " << path
+              << std::endl;
   }
-  return true;
-#endif
+  std::cout << "Merge completed in " << millisecondsSince(run_start) / 1000.0 << " s" << std::endl;
+  return 0;
 }
 
-/* Convert nlohmann::json to GeoJSONValue */
-GeoJSONValue jsonToGeoJSONValue(const json &j)
+int main(int argc, char **argv)
 {
-  if (j.is_null())
-  {
-    return GeoJSONValue();
-  }
-  else if (j.is_boolean())
-  {
-    return GeoJSONValue(j.get<bool>());
-  }
-  else if (j.is_number_integer())
-  {
-    return GeoJSONValue(static_cast<double>(j.get<int64_t>()));
-  }
-  else if (j.is_number_float())
-  {
-    return GeoJSONValue(j.get<double>());
-  }
-  else if (j.is_string())
-  {
-    return GeoJSONValue(j.get<std::string>());
-  }
-  else if (j.is_array())
+  try
   {
-    std::vector<GeoJSONValue> arr;
-    for (const auto &item : j)
+    Options options = parseArguments(argc, argv);
+    if (options.time_budget_s > 0.0)
     {
-      arr.push_back(jsonToGeoJSONValue(item));
+      installHullInterruptCallback();
     }
-    return GeoJSONValue(arr);
-  }
-  else if (j.is_object())
-  {
-    std::map<std::string, GeoJSONValue> obj;
-    for (auto it = j.begin(); it != j.end(); ++it)
+    if (options.serve)
     {
-      obj[it.key()] = jsonToGeoJSONValue(it.value());
+      return runServer(options);
     }
-    return GeoJSONValue(obj);
-  }
-  return GeoJSONValue();
-}
+    if (!options.sweep.empty())
+    {
+      return runSweep(options);
+    }
+    if (options.merge)
+    {
+      return runMerge(options);
+    }
+    auto run_start = std::chrono::steady_clock::now();
 
-int main()
-{
-  try
-  {
-    /* New factory with default (float) precision model */
-    GeometryFactory::Ptr factory = GeometryFactory::create();
+    /* Open the input; features are decoded one at a time by the workers */
+    bool quiet = options.log_level == LogLevel::Quiet;
+    FeatureFormat input_format = featureFormatForPath(options.input);
+    if (!quiet)
+    {
+      std::cout << "Reading " << formatDescription(input_format) << ": " << options.input << std::endl;
+    }
+    std::unique_ptr<FeatureReader> feature_stream = openFeatureReader(options.input);
 
-    /* Read GeoJSON file */
-    std::cout << "Reading GeoJSON file: " << SOURCE_DATA_FILE << std::endl;
-    std::string geojson_content = readFile(SOURCE_DATA_FILE);
+    /* Runtime filters: one summary pass over the raw records decides what gets decoded */
+    std::unique_ptr<FeatureSelection> selection;
+    if (!options.selection.empty())
+    {
+      selection = std::make_unique<FeatureSelection>(options.input, options.selection);
+      if (!quiet)
+      {
+        std::cout << "Selected " << selection->selectedCount() << " of " << selection->totalCount()
+                  << " features";
+        if (options.selection.shard.enabled())
+        {
+          std::cout << " (shard " << options.selection.shard.describe() << ": " << selection->ownedCount()
+                    << " features)";
+        }
+        std::cout << std::endl;
+      }
+    }
 
-    /* Create GeoJSON reader */
-    GeoJSONReader reader(*factory);
+    unsigned num_workers = options.threads;
+    size_t depth = options.queue_depth > 0 ? options.queue_depth : PIPELINE_DEPTH_PER_WORKER * num_workers;
+    if (!quiet)
+    {
+      std::cout << "Processing features";
+      if (num_workers > 1)
+      {
+        std::cout << " on " << num_workers << " threads";
+      }
+      std::cout << " (up to " << depth << " in flight)..." << std::endl;
+    }
 
-    /* Parse the GeoJSON */
-    GeoJSONFeatureCollection feature_collection = reader.readFeatures(geojson_content);
-    const std::vector<GeoJSONFeature> &features = feature_collection.getFeatures();
+    /*
+     * Three-stage pipeline. A parser thread scans the input for feature
+     * records and hands them to the worker pool through a bounded queue.
+     * Each worker owns a GeometryFactory (factory reference counts are not
+     * synchronized) and FeatureDecoder and decodes its record itself, so a
+     * worker stuck on Prospect Park doesn't hold up the playgrounds behind
+     * it. This thread is the writer: results are kept in input order and
+     * written below as soon as the oldest one is done, which keeps the
+     * output files identical to a serial run. At most `depth` features are
+     * in flight between the parser and the writer, so the parser waits when
+     * the writer falls behind and memory follows the queue depth, not the
+     * input size.
+     */
+    std::unique_ptr<HullCache> hull_cache;
+    if (!options.cache_dir.empty())
+    {
+      hull_cache = std::make_unique<HullCache>(options.cache_dir);
+    }
 
-    std::cout << "Processing " << features.size() << " features..." << std::endl;
+    /* Loaded completely before the outputs are opened, so it may be the output being replaced */
+    std::unique_ptr<PreviousOutput> previous;
+    if (!options.previous_path.empty())
+    {
+      previous = std::make_unique<PreviousOutput>(options.previous_path);
+      if (!quiet)
+      {
+        std::cout << "Loaded " << previous->size() << " previous hulls from: " << options.previous_path << std::endl;
+      }
+    }
 
-    /* Process each feature */
-    std::vector<GeoJSONFeature> output_features;            // For concave hulls only
-    std::vector<GeoJSONFeature> output_features_with_hulls; // For original + concave hull property
-    int processed = 0;
-    int skipped = 0;
+    /*
+     * Output files are written feature by feature as results come in. They,
+     * the log and the issue directory are opened before any thread starts,
+     * so a bad path fails the run before there is anything to stop.
+     */
+    std::unique_ptr<FeatureWriter> output_hulls = openFeatureWriter(options.output_hulls);           // Concave hulls only
+    std::unique_ptr<FeatureWriter> output_with_hulls = openFeatureWriter(options.output_with_hulls); // Original + concave hull property
+    std::unique_ptr<FeatureWriter> output_analysis;                                                  // ... plus the 2a metrics
+    if (!options.output_analysis.empty())
+    {
+      output_analysis = openFeatureWriter(options.output_analysis);
+    }
+    std::unique_ptr<FeatureLog> feature_log;
+    if (!options.log_path.empty())
+    {
+      feature_log = std::make_unique<FeatureLog>(options.log_path);
+    }
+    IssueWriter issue_writer(ISSUE_DIRECTORY);
 
-    for (const auto &feature : features)
+    std::vector<GeometryFactory::Ptr> worker_factories;
+    for (unsigned w = 0; w < num_workers; ++w)
     {
-      const Geometry *geom = feature.getGeometry();
-      const auto &properties = feature.getProperties();
+      worker_factories.push_back(GeometryFactory::create());
+    }
+
+    std::deque<FeatureResult> pending; // Features in flight, oldest first
+    bool input_done = false;
+    std::exception_ptr input_error;
+    std::atomic<bool> abort_workers{false};
+    std::mutex results_mutex;
+    std::condition_variable result_ready; // A result is done, or the input is exhausted
+    std::condition_variable window_free;  // The writer retired the oldest result
 
-      /* Check if this feature should be processed based on whitelist */
-      bool should_process = EAPPLY_WHITELIST.empty(); // If whitelist is empty, process all
+    struct ParsedRecord
+    {
+      std::string_view record; // Into the mapped input
+      FeatureResult *result = nullptr;
+    };
+    BoundedQueue<ParsedRecord> records(depth);
 
-      if (!EAPPLY_WHITELIST.empty())
+    auto parser = [&]()
+    {
+      try
       {
-        /* Check if feature has an "eapply" property and if it's in the whitelist */
-        auto eapply_it = properties.find("eapply");
-        if (eapply_it != properties.end() && eapply_it->second.isString())
+        std::string_view record;
+        for (;;)
         {
-          std::string eapply_value = eapply_it->second.getString();
-          should_process = EAPPLY_WHITELIST.count(eapply_value) > 0;
+          {
+            std::unique_lock<std::mutex> lock(results_mutex);
+            window_free.wait(lock, [&]
+                             { return abort_workers || pending.size() < depth; });
+            if (abort_workers)
+            {
+              break;
+            }
+          }
+          if (!feature_stream->next(record))
+          {
+            break;
+          }
+          FeatureResult *result = nullptr;
+          {
+            std::lock_guard<std::mutex> lock(results_mutex);
+            pending.emplace_back();
+            result = &pending.back();
+            result->profile.index = feature_stream->count() - 1;
+          }
+          if (!records.push({record, result}))
+          {
+            break;
+          }
         }
       }
-
-      if (!should_process)
+      catch (...)
       {
-        /* Keep unprocessed features in both outputs as-is */
-        std::unique_ptr<Geometry> geom_copy1(geom->clone());
-        GeoJSONFeature feature_copy1(std::move(geom_copy1), properties, feature.getId());
-        output_features.push_back(std::move(feature_copy1));
-
-        std::unique_ptr<Geometry> geom_copy2(geom->clone());
-        GeoJSONFeature feature_copy2(std::move(geom_copy2), properties, feature.getId());
-        output_features_with_hulls.push_back(std::move(feature_copy2));
-
-        skipped++;
-        continue;
+        input_error = std::current_exception(); // Rethrown once the features before it are written
+      }
+      records.close();
+      {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        input_done = true;
       }
+      result_ready.notify_all();
+    };
 
-      if (geom && geom->getGeometryTypeId() == GEOS_MULTIPOLYGON)
+    auto worker = [&](const GeometryFactory &worker_factory)
+    {
+      FeatureDecoder decoder(input_format, worker_factory);
+      configureDecoder(decoder, options);
+#ifndef NO_FEATURE_ARENA
+      std::unique_ptr<FeatureArena> arena;
+      if (options.arena)
+      {
+        arena = std::make_unique<FeatureArena>();
+      }
+#endif
+      ParsedRecord parsed_record;
+      while (!abort_workers && records.pop(parsed_record))
       {
-        /* Compute concave hull with adaptive threshold */
-        std::unique_ptr<Geometry> hull;
-        float current_threshold = CONCAVE_HULL_LENGTH_THRESHOLD;
-        int attempts = 0;
+        std::string_view feature_record = parsed_record.record;
+        FeatureResult *result = parsed_record.result;
 
+        bool selected = !selection || selection->contains(result->profile.index);
+        bool owned = !selection || selection->owns(result->profile.index);
         try
         {
-          std::cout << "Name: " << properties.find("name311")->second.getString() << std::endl;
-        }
-        catch (const std::exception &e)
-        {
-          std::cout << "Error: " << e.what() << std::endl;
-        }
-        for (attempts = 0; attempts < MAX_ATTEMPTS; attempts++)
-        {
-          try
-          {
-            std::cout << "Current threshold: " << current_threshold * METERS_PER_DEGREE << " meters" << std::endl;
-            hull = ConcaveHullOfPolygons::concaveHullByLength(
-                geom,
-                current_threshold,
-                true,   /* isTight - keep boundary tight to input polygons */
-                false); /* isHolesAllowed - don't allow holes in the hull */
-          }
-          catch (const std::exception &e)
+          if (!owned || (!selected && !options.keep_unselected))
           {
-            std::cout << "Error: " << e.what() << std::endl;
-            std::cout << "Concave Hull Failed, increasing threshold" << std::endl;
-            current_threshold += CONCAVE_HULL_LENGTH_INCREMENT;
-            continue;
+            result->skipped = true;
+            result->omitted = true;
           }
-
-          /* Check if result is a single polygon */
-          if (hull && hull->getGeometryTypeId() == GEOS_MULTIPOLYGON)
+          else
           {
-            const MultiPolygon *mp = dynamic_cast<const MultiPolygon *>(hull.get());
-            if (mp && mp->getNumGeometries() == 1)
+            auto process = [&](FeatureDecoder &feature_decoder, FeatureResult &target)
             {
-              /* Success! Single polygon achieved */
-              break;
+              auto feature_start = std::chrono::steady_clock::now();
+              std::string_view raw_properties;
+              GeoJSONFeatureCollection parsed = feature_decoder.decode(feature_record, &raw_properties);
+              target.profile.decode_ms = millisecondsSince(feature_start);
+              processFeature(parsed.getFeatures().at(0), raw_properties, selected, options, hull_cache.get(),
+                             previous.get(), target);
+              target.profile.total_ms = millisecondsSince(feature_start);
+            };
+#ifndef NO_FEATURE_ARENA
+            if (arena)
+            {
+              processInArena(*arena, *result, [&](FeatureResult &target)
+                             {
+                               /* Readers keep scratch buffers between records, which must not outlive the arena */
+                               FeatureDecoder arena_decoder(input_format, worker_factory);
+                               configureDecoder(arena_decoder, options);
+                               process(arena_decoder, target); });
+            }
+            else
+#endif
+            {
+              process(decoder, *result);
             }
           }
-          else if (hull && hull->getGeometryTypeId() == GEOS_POLYGON)
-          {
-            /* Result is a single Polygon (not even MultiPolygon), perfect! */
-            break;
-          }
+        }
+        catch (...)
+        {
+          result->error = std::current_exception();
+        }
 
-          /* Still multiple polygons, increase threshold and retry */
-          current_threshold += CONCAVE_HULL_LENGTH_INCREMENT;
+        {
+          std::lock_guard<std::mutex> lock(results_mutex);
+          result->done = true;
         }
+        result_ready.notify_all();
+      }
+    };
 
-        /* Log if multiple attempts were needed */
-        if (attempts > 0)
+    std::vector<std::thread> workers;
+    std::thread parser_thread;
+
+    auto join_workers = [&]()
+    {
+      if (parser_thread.joinable())
+      {
+        parser_thread.join();
+      }
+      for (auto &t : workers)
+      {
+        if (t.joinable())
         {
-          const auto &props = feature.getProperties();
-          auto eapply_it = props.find("eapply");
-          std::string park_name = "(unknown)";
-          if (eapply_it != props.end() && eapply_it->second.isString())
-          {
-            park_name = eapply_it->second.getString();
-          }
+          t.join();
+        }
+      }
+    };
+
+    /*
+     * Stops all three stages when this thread leaves the run early (a failed
+     * feature, an output write that throws): closing the queue releases a
+     * parser blocked in push() and workers waiting in pop(). After a complete
+     * run every thread has already finished and this only joins them.
+     */
+    OnScopeExit stop_pipeline([&]()
+                             {
+                               {
+                                 std::lock_guard<std::mutex> lock(results_mutex);
+                                 abort_workers = true;
+                               }
+                               window_free.notify_all();
+                               records.close();
+                               join_workers(); });
+    for (unsigned w = 0; w < num_workers; ++w)
+    {
+      workers.emplace_back(worker, std::cref(*worker_factories[w]));
+    }
+    parser_thread = std::thread(parser);
+
+    /* Process each feature */
+    int processed = 0;
+    int skipped = 0;
+    int cache_hits = 0;
+    int cache_misses = 0;
+    int previous_reused = 0;
+
+    /* --simplify effect over the hulls computed in this run */
+    size_t simplify_vertices_before = 0;
+    size_t simplify_vertices_after = 0;
+    int simplify_checked = 0;
+    int simplify_over_tolerance = 0;
+    int timed_out = 0;
+    int convex_fallbacks = 0;
+
+    /* --snap effect over the hulls computed in this run */
+    int snap_attempts = 0;
+    int snap_failed_attempts = 0;
+    int snap_checked = 0;
+    int unsnapped_attempts = 0;
+    int unsnapped_failed_attempts = 0;
+
+    /* --hierarchical features of this run, and how they compare with their direct hulls */
+    int hierarchical_features = 0;
+    size_t hierarchical_clusters = 0;
+    int hierarchical_checked = 0;
+    double hierarchical_ms = 0.0;
+    double direct_ms = 0.0;
+    double min_direct_iou = 1.0;
+    double min_direct_area_ratio = std::numeric_limits<double>::infinity();
+    double max_direct_area_ratio = 0.0;
+    double max_direct_hausdorff_m = 0.0;
+    double simplify_max_hausdorff_m = 0.0;
+    ProfileReport profile_report;
+
+    /* Input ordinals of the written features, for the shard index (--shard) */
+    std::vector<size_t> shard_ordinals;
+
+    /* MultiPolygons with more than one polygon; their files are written as they come in */
+    std::vector<std::string> multi_polygon_names;
+    std::vector<std::string> multi_polygon_files;
+    std::ostringstream cleanup_log;
+    int tiny_polygons_removed = 0;
+
+    for (;;)
+    {
+      FeatureResult *front = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(results_mutex);
+        result_ready.wait(lock, [&]
+                          { return (!pending.empty() && pending.front().done) || (input_done && pending.empty()); });
+        if (pending.empty())
+        {
+          break;
+        }
+        front = &pending.front(); // Stays valid while workers append
+      }
+      FeatureResult &result = *front;
+
+      if (options.log_level == LogLevel::Verbose)
+      {
+        std::cout << result.log;
+      }
+      if (!quiet)
+      {
+        std::cout << result.notice;
+      }
+      if (result.error)
+      {
+        std::rethrow_exception(result.error);
+      }
 
-          float final_threshold_meters = current_threshold * METERS_PER_DEGREE;
-          std::cout << "  ⚡ " << park_name << " required " << (attempts + 1)
-                    << " attempts (threshold: " << (int)final_threshold_meters << "m)" << std::endl;
+      if (!result.omitted)
+      {
+        output_hulls->write(result.hull_record);
+        output_with_hulls->write(result.with_hull_record);
+        if (output_analysis)
+        {
+          output_analysis->write(result.analysis_record);
+        }
+        if (options.selection.shard.enabled())
+        {
+          shard_ordinals.push_back(result.profile.index);
         }
+      }
 
-        /* Create feature with hull geometry for first output */
-        std::unique_ptr<Geometry> hull_copy(hull->clone());
-        GeoJSONFeature hull_feature(std::move(hull), feature.getProperties(), feature.getId());
-        output_features.push_back(std::move(hull_feature));
+      if (result.hulled && result.reused)
+      {
+        previous_reused++;
+      }
+      else if (result.hulled && result.cache_hit)
+      {
+        cache_hits++;
+      }
+      else if (result.hulled)
+      {
+        cache_misses++;
+      }
 
-        /* Create feature with original geometry + concave_hull_polygon property for second output */
-        std::unique_ptr<Geometry> original_geom_copy(geom->clone());
-        auto properties_with_hull = feature.getProperties();
+      const FeatureProfile &profile = result.profile;
+      if (profile.hulled && !profile.cache_hit && !profile.reused && options.simplify.mode != SimplifyMode::Off)
+      {
+        simplify_vertices_before += profile.vertices;
+        simplify_vertices_after += profile.hull_vertices;
+        if (profile.hausdorff_m >= 0.0)
+        {
+          simplify_checked++;
+          simplify_max_hausdorff_m = std::max(simplify_max_hausdorff_m, profile.hausdorff_m);
+          if (profile.hausdorff_m > profile.simplify_tolerance_m)
+          {
+            simplify_over_tolerance++;
+          }
+        }
+      }
 
-        /* Serialize concave hull to GeoJSON and add as property */
-        GeoJSONWriter geom_writer;
-        std::string hull_geojson = geom_writer.write(hull_copy.get());
+      timed_out += profile.timed_out;
+      convex_fallbacks += profile.convex_hull;
+      if (profile.clusters > 0)
+      {
+        hierarchical_features++;
+        hierarchical_clusters += profile.clusters;
+        if (profile.direct_iou >= 0.0)
+        {
+          hierarchical_checked++;
+          hierarchical_ms += profile.hierarchical_ms;
+          direct_ms += profile.direct_ms;
+          min_direct_iou = std::min(min_direct_iou, profile.direct_iou);
+          min_direct_area_ratio = std::min(min_direct_area_ratio, profile.direct_area_ratio);
+          max_direct_area_ratio = std::max(max_direct_area_ratio, profile.direct_area_ratio);
+          max_direct_hausdorff_m = std::max(max_direct_hausdorff_m, profile.direct_hausdorff_m);
+        }
+      }
+      if (profile.hulled && !profile.cache_hit && !profile.reused && options.snap.enabled())
+      {
+        snap_attempts += profile.attempts;
+        snap_failed_attempts += profile.failed_attempts;
+        if (profile.unsnapped_attempts >= 0)
+        {
+          snap_checked++;
+          unsnapped_attempts += profile.unsnapped_attempts;
+          unsnapped_failed_attempts += profile.unsnapped_failed_attempts;
+        }
+      }
 
-        /* Parse the JSON string and convert to GeoJSONValue object */
-        json hull_json = json::parse(hull_geojson);
-        properties_with_hull["concave_hull_polygon"] = jsonToGeoJSONValue(hull_json);
+      if (feature_log && !result.omitted)
+      {
+        feature_log->write(result.profile, result.tiny_removed, result.has_issue,
+                           result.log + result.notice + result.cleanup_log);
+      }
+      if (!options.profile_path.empty() && !result.omitted)
+      {
+        profile_report.add(std::move(result.profile));
+      }
 
-        GeoJSONFeature feature_with_hull(std::move(original_geom_copy), properties_with_hull, feature.getId());
-        output_features_with_hulls.push_back(std::move(feature_with_hull));
+      if (!quiet)
+      {
+        cleanup_log << result.cleanup_log;
+      }
+      tiny_polygons_removed += result.tiny_parts_removed;
+      if (result.has_issue)
+      {
+        multi_polygon_names.push_back(result.issue_name);
+        multi_polygon_files.push_back(issue_writer.submit(std::move(result.issue_json)));
+      }
 
+      if (!result.skipped)
+      {
         processed++;
-        if (processed % 100 == 0)
+        if (!quiet && result.hulled && processed % 100 == 0)
         {
           std::cout << "  Processed " << processed << " features..." << std::endl;
         }
       }
       else
       {
-        /* Keep the feature as-is if it's not a MultiPolygon */
-        /* Need to make a copy since the original is const */
-        std::unique_ptr<Geometry> geom_copy(geom->clone());
-        GeoJSONFeature new_feature(std::move(geom_copy), feature.getProperties(), feature.getId());
-        output_features.push_back(std::move(new_feature));
-
-        /* Also add to second output (no concave hull property for non-MultiPolygon) */
-        std::unique_ptr<Geometry> geom_copy2(geom->clone());
-        GeoJSONFeature new_feature2(std::move(geom_copy2), feature.getProperties(), feature.getId());
-        output_features_with_hulls.push_back(std::move(new_feature2));
+        skipped++;
+      }
 
-        processed++;
+      {
+        std::lock_guard<std::mutex> lock(results_mutex);
+        pending.pop_front();
       }
+      window_free.notify_one();
+    }
+    join_workers();
+    if (input_error)
+    {
+      std::rethrow_exception(input_error);
     }
 
     std::cout << "Processed " << processed << " features" << std::endl;
     if (skipped > 0)
     {
-      std::cout << "Skipped " << skipped << " features (not in whitelist)" << std::endl;
+      std::cout << "Skipped " << skipped << " features (not selected"
+                << (options.keep_unselected ? ", copied unchanged" : ", left out of the outputs") << ")" << std::endl;
+    }
+    if (previous)
+    {
+      std::cout << "Previous output: reused " << previous_reused << " hull(s), "
+                << cache_hits + cache_misses << " new or changed feature(s)" << std::endl;
+    }
+    if (hull_cache)
+    {
+      std::cout << "Hull cache: " << cache_hits << " hit(s), " << cache_misses << " miss(es) in "
+                << options.cache_dir << std::endl;
     }
 
-    /* Check for MultiPolygons with more than one polygon */
-    std::vector<std::string> multi_polygon_names;
-    std::vector<GeoJSONFeature> multi_polygon_features;
-    int tiny_polygons_removed = 0;
-
-    for (size_t i = 0; i < output_features.size(); ++i)
+    if (options.simplify.mode != SimplifyMode::Off)
     {
-      auto &feature = output_features[i];
-      const Geometry *geom = feature.getGeometry();
-      if (geom && geom->getGeometryTypeId() == GEOS_MULTIPOLYGON)
+      std::cout << "Pre-simplification (" << options.simplify.describe() << "): " << simplify_vertices_before
+                << " -> " << simplify_vertices_after << " hull input vertices" << std::endl;
+      if (options.simplify_check)
       {
-        const MultiPolygon *mp = dynamic_cast<const MultiPolygon *>(geom);
-        if (mp && mp->getNumGeometries() > 1)
-        {
-          /* Find the eapply value for this feature */
-          const auto &properties = feature.getProperties();
-          auto eapply_it = properties.find("eapply");
-          std::string eapply_name;
-          if (eapply_it != properties.end() && eapply_it->second.isString())
-          {
-            eapply_name = eapply_it->second.getString();
-          }
-          else
-          {
-            eapply_name = "(no eapply value)";
-          }
-
-          /* Edge case: if exactly 2 polygons and one is tiny, remove the tiny one */
-          bool handled = false;
-          if (mp->getNumGeometries() == 2)
-          {
-            const Geometry *poly1 = mp->getGeometryN(0);
-            const Geometry *poly2 = mp->getGeometryN(1);
-            double area1 = poly1->getArea();
-            double area2 = poly2->getArea();
-
-            const Geometry *larger_poly = nullptr;
-            double smaller_area = 0.0;
-
-            if (area1 < area2 && area1 < TINY_POLYGON_AREA_THRESHOLD)
-            {
-              larger_poly = poly2;
-              smaller_area = area1;
-              handled = true;
-            }
-            else if (area2 < area1 && area2 < TINY_POLYGON_AREA_THRESHOLD)
-            {
-              larger_poly = poly1;
-              smaller_area = area2;
-              handled = true;
-            }
-
-            if (handled && larger_poly)
-            {
-              /* Remove the tiny polygon by keeping only the larger one */
-              std::unique_ptr<Geometry> larger_copy(larger_poly->clone());
-              GeoJSONFeature new_feature(std::move(larger_copy), properties, feature.getId());
-              output_features[i] = std::move(new_feature);
-
-              double smaller_area_sqm = smaller_area * SQ_METERS_PER_SQ_DEGREE;
-              std::cout << "  ✓ " << eapply_name << ": Removed tiny polygon ("
-                        << (int)smaller_area_sqm << " sq m)" << std::endl;
-              tiny_polygons_removed++;
-            }
-          }
+        std::cout << "  Checked " << simplify_checked << " hull(s): max Hausdorff distance "
+                  << simplify_max_hausdorff_m << " m, " << simplify_over_tolerance
+                  << " above their simplification tolerance" << std::endl;
+      }
+    }
 
-          /* If not handled by edge case, add to problematic list */
-          if (!handled)
-          {
-            multi_polygon_names.push_back(eapply_name);
+    if (options.snap.enabled())
+    {
+      std::cout << "Snapping (grid " << options.snap.grid_m << " m): " << snap_failed_attempts << " of "
+                << snap_attempts << " hull attempt(s) failed" << std::endl;
+      if (options.snap_check)
+      {
+        std::cout << "  Checked " << snap_checked << " hull(s): " << unsnapped_failed_attempts - snap_failed_attempts
+                  << " failed attempt(s) avoided, " << unsnapped_attempts - snap_attempts
+                  << " attempt(s) saved (unsnapped: " << unsnapped_failed_attempts << " of " << unsnapped_attempts
+                  << " failed)" << std::endl;
+      }
+    }
 
-            /* Copy the feature for the separate file */
-            std::unique_ptr<Geometry> geom_copy(geom->clone());
-            GeoJSONFeature feature_copy(std::move(geom_copy), properties, feature.getId());
-            multi_polygon_features.push_back(std::move(feature_copy));
-          }
-        }
+    if (options.hierarchical.enabled())
+    {
+      std::cout << "Hierarchical hulls (" << options.hierarchical.min_parts << "+ parts, clusters of at most "
+                << options.hierarchical.cluster_parts << "): " << hierarchical_features << " feature(s), "
+                << hierarchical_clusters << " cluster(s)" << std::endl;
+      if (options.hierarchical_check && hierarchical_checked > 0)
+      {
+        std::cout << "  Checked " << hierarchical_checked << " hull(s): " << hierarchical_ms << " ms vs " << direct_ms
+                  << " ms direct, area ratio " << min_direct_area_ratio << " - " << max_direct_area_ratio
+                  << ", min IoU " << min_direct_iou << ", max Hausdorff distance " << max_direct_hausdorff_m
+                  << " m" << std::endl;
       }
     }
 
+    if (options.time_budget_s > 0.0)
+    {
+      std::cout << "Time budget (" << options.time_budget_s << " s): " << timed_out << " feature(s) ran out of time, "
+                << convex_fallbacks << " of them before any hull (convex hull written)" << std::endl;
+    }
+
+    std::cout << cleanup_log.str();
+
     if (tiny_polygons_removed > 0)
     {
       std::cout << "\n✓ Removed " << tiny_polygons_removed
@@ -432,45 +2290,65 @@ int main()
       }
       std::cout << "\nConsider increasing CONCAVE_HULL_LENGTH_THRESHOLD to merge these polygons." << std::endl;
 
-      /* Write each multi-polygon issue as a separate GeoJSON file in 'issue_geojson/' */
-      const std::string issue_dir = "temp/issue_geojson";
-      if (!createDirectoryIfNotExists(issue_dir))
-      {
-        std::cerr << "Warning: Failed to create directory '" << issue_dir << "'" << std::endl;
-      }
-      else
+      /* Each multi-polygon issue went to a separate GeoJSON file in 'issue_geojson/' */
+      try
       {
-        GeoJSONWriter single_issue_writer;
-        for (size_t i = 0; i < multi_polygon_features.size(); ++i)
+        issue_writer.close();
+        for (const auto &filename : multi_polygon_files)
         {
-          const GeoJSONFeature &issue_feature = multi_polygon_features[i];
-          GeoJSONFeatureCollection single_feature_collection({issue_feature});
-          std::string single_geojson = single_issue_writer.write(single_feature_collection);
-          std::string filename = issue_dir + "/issue_" + std::to_string(i + 1) + ".geojson";
-          writeFile(filename.c_str(), single_geojson);
           std::cout << "  - Written to: " << filename << std::endl;
         }
       }
+      catch (const std::exception &e)
+      {
+        std::cerr << "Warning: " << e.what() << std::endl;
+      }
     }
     else if (processed > 0)
     {
       std::cout << "\n✓ All processed features have single-polygon geometries." << std::endl;
     }
 
-    /* Write output GeoJSON files */
-    GeoJSONWriter writer;
+    if (feature_log)
+    {
+      feature_log->close();
+      std::cout << "Feature log written to: " << options.log_path << std::endl;
+    }
+
+    /* Finish output files */
+    output_hulls->close();
+    std::cout << "Concave hulls written to: " << options.output_hulls << std::endl;
+
+    output_with_hulls->close();
+    std::cout << "Original geometries with concave hulls written to: " << options.output_with_hulls << std::endl;
+
+    if (output_analysis)
+    {
+      output_analysis->close();
+      std::cout << "Concave hull analysis written to: " << options.output_analysis << std::endl;
+    }
+
+    if (options.selection.shard.enabled())
+    {
+      std::string index_path = shardIndexPath(options.output_hulls);
+      writeShardIndex(index_path, options.selection.shard, feature_stream->count(), shard_ordinals);
+      std::cout << "Shard index written to: " << index_path << std::endl;
+    }
+
+    if (!options.profile_path.empty())
+    {
+      ProfileRunInfo run;
+      run.threads = num_workers;
+      run.search = options.search == SearchStrategy::Bisect ? "bisect" : "linear";
+      run.input = options.input;
+      run.wall_ms = millisecondsSince(run_start);
+      run.peak_memory_bytes = peakMemoryBytes();
+      run.arena = options.arena;
+      profile_report.write(options.profile_path, run);
+      std::cout << "Profile report written to: " << options.profile_path << std::endl;
+    }
 
-    /* Write concave hulls only */
-    GeoJSONFeatureCollection output_collection_hulls(std::move(output_features));
-    std::string output_geojson_hulls = writer.write(output_collection_hulls);
-    writeFile(OUTPUT_PATH_HULLS, output_geojson_hulls);
-    std::cout << "Concave hulls written to: " << OUTPUT_PATH_HULLS << std::endl;
-
-    /* Write original geometries with concave hull properties */
-    GeoJSONFeatureCollection output_collection_with_hulls(std::move(output_features_with_hulls));
-    std::string output_geojson_with_hulls = writer.write(output_collection_with_hulls);
-    writeFile(OUTPUT_PATH_WITH_HULLS, output_geojson_with_hulls);
-    std::cout << "Original geometries with concave hulls written to: " << OUTPUT_PATH_WITH_HULLS << std::endl;
+    std::cout << "Peak memory usage: " << peakMemoryBytes() / (1024 * 1024) << " MB" << std::endl;
 
     return 0;
   }
@@ -0,0 +1,309 @@
+/*
+ * Benchmark for the concave hull stage (1a).
+ *
+ * Splits the stage input into fixed corpora by size and shape, decodes every
+ * feature up front, and then times only the per-feature work of the stage:
+ * the threshold lower bound, the adaptive hull search and the encoding of
+ * both output records. File I/O and logging stay outside the timed region.
+ *
+ * Corpora:
+ *   tiny   single-polygon features under TINY_MAX_VERTICES vertices (playgrounds, malls)
+ *   mid    multi-part features below the "worst" limits
+ *   worst  features with at least WORST_MIN_POLYGONS polygons or WORST_MIN_VERTICES
+ *          vertices, plus the Meredith Woods sample
+ *
+ * "peak MB" is the process high-water mark after each corpus, so it includes
+ * the decoded corpora themselves.
+ *
+ * --check-search runs the linear and the bisect search (with GEOS alone)
+ * and the triangulated search on every feature of the corpora instead and
+ * fails if they pick different steps.
+ */
+
+#define GEOS_USE_ONLY_R_API
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <geos/geom/Geometry.h>
+#include <geos/geom/GeometryFactory.h>
+#include <geos/io/GeoJSONWriter.h>
+
+#include "../src/feature_io.h"
+#include "../src/geojson_feature.h"
+#include "../src/hull_engine.h"
+#include "../src/hull_settings.h"
+#include "../src/profile_report.h"
+
+using namespace geos::geom;
+using namespace geos::io;
+
+const char *DEFAULT_INPUT = "./output_data/0c_parks_filtered_augmented.geojson";
+const char *MEREDITH_WOODS_SAMPLE = "./source_data/meredith_woods_modified.geojson";
+
+const size_t TINY_MAX_VERTICES = 100;
+const size_t WORST_MIN_POLYGONS = 20;
+const size_t WORST_MIN_VERTICES = 2000;
+
+/* Upper bound on features per corpus, taken in input order */
+const size_t MAX_CORPUS_FEATURES = 500;
+
+struct Corpus
+{
+  std::string name;
+  std::vector<GeoJSONFeatureCollection> features; // One decoded feature each
+};
+
+struct BenchOptions
+{
+  std::string input = DEFAULT_INPUT;
+  int repeat = 3;
+  SearchStrategy search = SearchStrategy::Linear;
+  bool check_search = false;
+};
+
+void printUsage(const char *program)
+{
+  std::cout << "Usage: " << program << " [--input PATH] [--repeat N] [--search linear|bisect] [--check-search]\n"
+            << "  --input PATH      Stage input to build the corpora from (default " << DEFAULT_INPUT << ")\n"
+            << "  --repeat N        Timed passes over each corpus (default 3)\n"
+            << "  --search STRATEGY Threshold search strategy, as for 1a_concave_hull\n"
+            << "  --check-search    Check that both search strategies and the triangulation pick the\n"
+            << "                    same step for every feature instead of timing" << std::endl;
+}
+
+BenchOptions parseArguments(int argc, char **argv)
+{
+  BenchOptions options;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--input" && i + 1 < argc)
+    {
+      options.input = argv[++i];
+    }
+    else if (arg == "--repeat" && i + 1 < argc)
+    {
+      std::string value = argv[++i];
+      if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || std::stoi(value) < 1)
+      {
+        throw std::runtime_error("Invalid value for --repeat: " + value);
+      }
+      options.repeat = std::stoi(value);
+    }
+    else if (arg == "--search" && i + 1 < argc)
+    {
+      std::string value = argv[++i];
+      if (value == "linear")
+      {
+        options.search = SearchStrategy::Linear;
+      }
+      else if (value == "bisect")
+      {
+        options.search = SearchStrategy::Bisect;
+      }
+      else
+      {
+        throw std::runtime_error("Invalid value for --search: " + value);
+      }
+    }
+    else if (arg == "--check-search")
+    {
+      options.check_search = true;
+    }
+    else if (arg == "--help" || arg == "-h")
+    {
+      printUsage(argv[0]);
+      std::exit(0);
+    }
+    else
+    {
+      throw std::runtime_error("Unknown argument: " + arg);
+    }
+  }
+  return options;
+}
+
+/* Append every MultiPolygon feature of `path` accepted by `select` to `corpus` */
+template <typename Select>
+void loadCorpus(const std::string &path, const GeometryFactory &factory, Select select, Corpus &corpus)
+{
+  std::unique_ptr<FeatureReader> reader = openFeatureReader(path);
+  FeatureDecoder decoder(featureFormatForPath(path), factory);
+  std::string_view record;
+  while (corpus.features.size() < MAX_CORPUS_FEATURES && reader->next(record))
+  {
+    GeoJSONFeatureCollection parsed = decoder.decode(record);
+    const Geometry *geom = parsed.getFeatures().at(0).getGeometry();
+    if (geom && geom->getGeometryTypeId() == GEOS_MULTIPOLYGON && select(geom))
+    {
+      corpus.features.push_back(std::move(parsed));
+    }
+  }
+}
+
+/* The stage's work on one feature, minus caching and console output; returns the attempts */
+int hullFeature(const GeoJSONFeature &feature, SearchStrategy search, std::ostream &null_log)
+{
+  const Geometry *geom = feature.getGeometry();
+  HullEngine engine(geom, HULL_PARAMETERS);
+  HullSearchResult result = engine.search(search, null_log);
+
+  GeoJSONWriter writer;
+  std::vector<RawProperty> hull_extras{
+      {"concave_hull_threshold_m", propertyValueJson(GeoJSONValue(thresholdMetersForStep(result.step)))}};
+  std::vector<RawProperty> original_extras = hull_extras;
+
+  std::string hull_geojson = writer.write(result.hull.get());
+  original_extras.push_back({"concave_hull_polygon", geometryPropertyJson(hull_geojson), result.hull.get()});
+  std::string hull_record = writeFeatureJson(hull_geojson, feature.getProperties(), hull_extras, feature.getId());
+  std::string with_hull_record =
+      writeFeatureJson(writer.write(geom), feature.getProperties(), original_extras, feature.getId());
+  return result.attempts;
+}
+
+/* "step N" or "step N (no single polygon)" */
+std::string describeStep(const HullSearchResult &result)
+{
+  return "step " + std::to_string(result.step) + (isSinglePolygon(result.hull.get()) ? "" : " (no single polygon)");
+}
+
+/* Whether `a` and `b` end on the same single-polygon step, or both without one */
+bool sameStep(const HullSearchResult &a, const HullSearchResult &b)
+{
+  bool single = isSinglePolygon(a.hull.get());
+  return single == isSinglePolygon(b.hull.get()) && (!single || a.step == b.step);
+}
+
+/*
+ * Features of `corpus` whose searches pick different steps, printed as
+ * found; `shortcuts` counts the features whose step the triangulation named
+ * without a step by step search
+ */
+size_t checkSearch(const Corpus &corpus, size_t &shortcuts)
+{
+  std::ostream null_log(nullptr);
+  size_t mismatches = 0;
+  for (const GeoJSONFeatureCollection &parsed : corpus.features)
+  {
+    const GeoJSONFeature &feature = parsed.getFeatures()[0];
+    HullEngine engine(feature.getGeometry(), HULL_PARAMETERS);
+    HullSearchResult triangulated = engine.search(SearchStrategy::Linear, null_log);
+    engine.setTriangulated(false);
+    HullSearchResult linear = engine.search(SearchStrategy::Linear, null_log);
+    HullSearchResult bisect = engine.search(SearchStrategy::Bisect, null_log);
+    shortcuts += triangulated.eroded_step >= 0 && triangulated.step == triangulated.eroded_step &&
+                 triangulated.attempts <= 2;
+    if (!sameStep(linear, bisect) || !sameStep(linear, triangulated))
+    {
+      auto name = feature.getProperties().find("eapply");
+      std::cout << "  " << corpus.name << ": "
+                << (name != feature.getProperties().end() && name->second.isString() ? name->second.getString() : "?")
+                << ": linear " << describeStep(linear) << ", bisect " << describeStep(bisect) << ", triangulated "
+                << describeStep(triangulated) << std::endl;
+      mismatches++;
+    }
+  }
+  return mismatches;
+}
+
+void runCorpus(const Corpus &corpus, const BenchOptions &options)
+{
+  std::ostream null_log(nullptr); // Discards the engine's per-attempt messages
+  std::vector<double> latencies_ms;
+  latencies_ms.reserve(corpus.features.size() * options.repeat);
+  long attempts = 0;
+
+  auto corpus_start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < options.repeat; ++pass)
+  {
+    for (const GeoJSONFeatureCollection &parsed : corpus.features)
+    {
+      auto start = std::chrono::steady_clock::now();
+      attempts += hullFeature(parsed.getFeatures()[0], options.search, null_log);
+      latencies_ms.push_back(millisecondsSince(start));
+    }
+  }
+  double total_ms = millisecondsSince(corpus_start);
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+
+  double features_per_second = total_ms > 0.0 ? latencies_ms.size() * 1000.0 / total_ms : 0.0;
+  std::printf("%-6s %8zu %10.1f %9.3f %9.3f %9.3f %9.3f %9.1f %8zu\n",
+              corpus.name.c_str(),
+              corpus.features.size(),
+              features_per_second,
+              percentileOfSorted(latencies_ms, 50),
+              percentileOfSorted(latencies_ms, 90),
+              percentileOfSorted(latencies_ms, 99),
+              latencies_ms.empty() ? 0.0 : latencies_ms.back(),
+              latencies_ms.empty() ? 0.0 : static_cast<double>(attempts) / latencies_ms.size(),
+              peakMemoryBytes() / (1024 * 1024));
+}
+
+int main(int argc, char **argv)
+{
+  try
+  {
+    BenchOptions options = parseArguments(argc, argv);
+    GeometryFactory::Ptr factory = GeometryFactory::create();
+
+    std::vector<Corpus> corpora(3);
+    corpora[0].name = "tiny";
+    corpora[1].name = "mid";
+    corpora[2].name = "worst";
+
+    auto is_worst = [](const Geometry *g)
+    {
+      return g->getNumGeometries() >= WORST_MIN_POLYGONS || g->getNumPoints() >= WORST_MIN_VERTICES;
+    };
+    loadCorpus(options.input, *factory, [](const Geometry *g)
+               { return g->getNumGeometries() == 1 && g->getNumPoints() < TINY_MAX_VERTICES; }, corpora[0]);
+    loadCorpus(options.input, *factory, [&](const Geometry *g)
+               { return g->getNumGeometries() > 1 && !is_worst(g); }, corpora[1]);
+    loadCorpus(MEREDITH_WOODS_SAMPLE, *factory, [](const Geometry *)
+               { return true; }, corpora[2]);
+    loadCorpus(options.input, *factory, is_worst, corpora[2]);
+
+    if (options.check_search)
+    {
+      size_t features = 0;
+      size_t mismatches = 0;
+      size_t shortcuts = 0;
+      for (const Corpus &corpus : corpora)
+      {
+        features += corpus.features.size();
+        mismatches += checkSearch(corpus, shortcuts);
+      }
+      std::cout << "The triangulation named the step of " << shortcuts << " of " << features << " features"
+                << std::endl;
+      if (mismatches > 0)
+      {
+        std::cerr << "Error: the searches picked different steps for " << mismatches
+                  << " of " << features << " features" << std::endl;
+        return 1;
+      }
+      std::cout << "Linear, bisect and triangulated search pick the same step for all " << features << " features"
+                << std::endl;
+      return 0;
+    }
+
+    std::cout << "Input: " << options.input << ", " << options.repeat << " pass(es), "
+              << (options.search == SearchStrategy::Bisect ? "bisect" : "linear") << " search" << std::endl;
+    std::printf("%-6s %8s %10s %9s %9s %9s %9s %9s %8s\n",
+                "corpus", "features", "features/s", "p50 ms", "p90 ms", "p99 ms", "max ms", "attempts", "peak MB");
+    for (const Corpus &corpus : corpora)
+    {
+      runCorpus(corpus, options);
+    }
+    return 0;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
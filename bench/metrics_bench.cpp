@@ -0,0 +1,227 @@
+/*
+ * Check and benchmark for the flattened-ring metric kernels (src/ring_metrics.h).
+ *
+ * Decodes every Polygon/MultiPolygon feature of the stage input up front,
+ * then compares area, perimeter, envelope and centroid from the kernels with
+ * GEOS's own getArea(), getLength(), getEnvelopeInternal() and
+ * getCentroid(), and times both. Areas, lengths and centroids may differ in
+ * the last bits (the kernels sum in a different order); anything beyond
+ * MAX_RELATIVE_ERROR fails the run. GEOS caches envelopes, so the envelope is
+ * only checked, not timed.
+ *
+ * Kernel times are over rings flattened beforehand; "flatten" is the copy
+ * into x/y arrays, and "all" compares GEOS's three metrics with flattening
+ * plus every kernel, which is what a caller pays.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <geos/geom/Envelope.h>
+#include <geos/geom/Geometry.h>
+#include <geos/geom/GeometryFactory.h>
+#include <geos/geom/Point.h>
+
+#include "../src/feature_io.h"
+#include "../src/profile_report.h"
+#include "../src/ring_metrics.h"
+
+using namespace geos::geom;
+using namespace geos::io;
+
+const char *DEFAULT_INPUT = "./output_data/0c_parks_filtered_augmented.geojson";
+
+/* Largest accepted difference from GEOS, relative to the value (centroids: to the envelope size) */
+const double MAX_RELATIVE_ERROR = 1e-9;
+
+struct BenchOptions
+{
+  std::string input = DEFAULT_INPUT;
+  int repeat = 20;
+};
+
+void printUsage(const char *program)
+{
+  std::cout << "Usage: " << program << " [--input PATH] [--repeat N]\n"
+            << "  --input PATH      Features to measure (default " << DEFAULT_INPUT << ")\n"
+            << "  --repeat N        Timed passes over the features (default 20)" << std::endl;
+}
+
+BenchOptions parseArguments(int argc, char **argv)
+{
+  BenchOptions options;
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    if (arg == "--input" && i + 1 < argc)
+    {
+      options.input = argv[++i];
+    }
+    else if (arg == "--repeat" && i + 1 < argc)
+    {
+      std::string value = argv[++i];
+      if (value.empty() || value.find_first_not_of("0123456789") != std::string::npos || std::stoi(value) < 1)
+      {
+        throw std::runtime_error("Invalid value for --repeat: " + value);
+      }
+      options.repeat = std::stoi(value);
+    }
+    else if (arg == "--help" || arg == "-h")
+    {
+      printUsage(argv[0]);
+      std::exit(0);
+    }
+    else
+    {
+      throw std::runtime_error("Unknown argument: " + arg);
+    }
+  }
+  return options;
+}
+
+/* Largest relative difference seen per metric */
+struct Errors
+{
+  double area = 0.0;
+  double length = 0.0;
+  double centroid = 0.0;
+  size_t envelope_mismatches = 0;
+};
+
+double relativeError(double value, double reference, double scale)
+{
+  return scale > 0.0 ? std::abs(value - reference) / scale : std::abs(value - reference);
+}
+
+void checkFeature(const Geometry &geometry, Errors &errors)
+{
+  FlatPolygons flat = flattenPolygons(geometry);
+  double area = geometry.getArea();
+  double length = geometry.getLength();
+  errors.area = std::max(errors.area, relativeError(totalArea(flat), area, area));
+  errors.length = std::max(errors.length, relativeError(totalLength(flat), length, length));
+
+  const Envelope &envelope = *geometry.getEnvelopeInternal();
+  Envelope flat_envelope = envelopeOf(flat);
+  if (flat_envelope.getMinX() != envelope.getMinX() || flat_envelope.getMaxX() != envelope.getMaxX() ||
+      flat_envelope.getMinY() != envelope.getMinY() || flat_envelope.getMaxY() != envelope.getMaxY())
+  {
+    errors.envelope_mismatches++;
+  }
+
+  double centroid_x = 0.0;
+  double centroid_y = 0.0;
+  if (areaCentroid(flat, centroid_x, centroid_y))
+  {
+    std::unique_ptr<Point> centroid = geometry.getCentroid();
+    double scale = std::max(envelope.getWidth(), envelope.getHeight());
+    errors.centroid = std::max({errors.centroid, relativeError(centroid_x, centroid->getX(), scale),
+                                relativeError(centroid_y, centroid->getY(), scale)});
+  }
+}
+
+/* Milliseconds per pass of `work` over every geometry; the sum keeps the work from being optimized out */
+template <typename Work>
+double timePasses(const std::vector<const Geometry *> &geometries, int repeat, Work work, double &sink)
+{
+  auto start = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < repeat; ++pass)
+  {
+    for (size_t i = 0; i < geometries.size(); ++i)
+    {
+      sink += work(i);
+    }
+  }
+  return millisecondsSince(start) / repeat;
+}
+
+int main(int argc, char **argv)
+{
+  try
+  {
+    BenchOptions options = parseArguments(argc, argv);
+    GeometryFactory::Ptr factory = GeometryFactory::create();
+
+    std::vector<GeoJSONFeatureCollection> features;
+    std::vector<const Geometry *> geometries;
+    std::unique_ptr<FeatureReader> reader = openFeatureReader(options.input);
+    FeatureDecoder decoder(featureFormatForPath(options.input), *factory);
+    std::string_view record;
+    size_t vertices = 0;
+    while (reader->next(record))
+    {
+      GeoJSONFeatureCollection parsed = decoder.decode(record);
+      const Geometry *geom = parsed.getFeatures().at(0).getGeometry();
+      if (geom && (geom->getGeometryTypeId() == GEOS_POLYGON || geom->getGeometryTypeId() == GEOS_MULTIPOLYGON))
+      {
+        vertices += geom->getNumPoints();
+        geometries.push_back(geom);
+        features.push_back(std::move(parsed));
+      }
+    }
+
+    Errors errors;
+    for (const Geometry *geom : geometries)
+    {
+      checkFeature(*geom, errors);
+    }
+
+    std::vector<FlatPolygons> flattened;
+    for (const Geometry *geom : geometries)
+    {
+      flattened.push_back(flattenPolygons(*geom));
+    }
+
+    double sink = 0.0;
+    double geos_area_ms = timePasses(geometries, options.repeat, [&](size_t i)
+                                     { return geometries[i]->getArea(); }, sink);
+    double geos_length_ms = timePasses(geometries, options.repeat, [&](size_t i)
+                                       { return geometries[i]->getLength(); }, sink);
+    double geos_centroid_ms = timePasses(geometries, options.repeat, [&](size_t i)
+                                         { return geometries[i]->getCentroid()->getX(); }, sink);
+    double flatten_ms = timePasses(geometries, options.repeat, [&](size_t i)
+                                   { return static_cast<double>(flattenPolygons(*geometries[i]).x.size()); }, sink);
+    double area_ms = timePasses(geometries, options.repeat, [&](size_t i)
+                                { return totalArea(flattened[i]); }, sink);
+    double length_ms = timePasses(geometries, options.repeat, [&](size_t i)
+                                  { return totalLength(flattened[i]); }, sink);
+    double centroid_ms = timePasses(geometries, options.repeat, [&](size_t i)
+                                    {
+                                      double x = 0.0, y = 0.0;
+                                      areaCentroid(flattened[i], x, y);
+                                      return x; }, sink);
+    double envelope_ms = timePasses(geometries, options.repeat, [&](size_t i)
+                                    { return envelopeOf(flattened[i]).getMinX(); }, sink);
+
+    std::cout << "Input: " << options.input << ", " << geometries.size() << " features, " << vertices
+              << " vertices, " << options.repeat << " pass(es) (checksum " << sink << ")" << std::endl;
+    std::printf("%-9s %10s %10s %12s\n", "metric", "GEOS ms", "kernels ms", "max rel err");
+    std::printf("%-9s %10.3f %10.3f %12.3g\n", "area", geos_area_ms, area_ms, errors.area);
+    std::printf("%-9s %10.3f %10.3f %12.3g\n", "perimeter", geos_length_ms, length_ms, errors.length);
+    std::printf("%-9s %10.3f %10.3f %12.3g\n", "centroid", geos_centroid_ms, centroid_ms, errors.centroid);
+    std::printf("%-9s %10s %10.3f %12zu mismatch(es)\n", "envelope", "-", envelope_ms, errors.envelope_mismatches);
+    std::printf("%-9s %10s %10.3f\n", "flatten", "-", flatten_ms);
+    std::printf("%-9s %10.3f %10.3f\n", "all", geos_area_ms + geos_length_ms + geos_centroid_ms,
+                flatten_ms + area_ms + length_ms + centroid_ms + envelope_ms);
+
+    if (errors.area > MAX_RELATIVE_ERROR || errors.length > MAX_RELATIVE_ERROR ||
+        errors.centroid > MAX_RELATIVE_ERROR || errors.envelope_mismatches > 0)
+    {
+      std::cerr << "Error: kernel results differ from GEOS by more than " << MAX_RELATIVE_ERROR << std::endl;
+      return 1;
+    }
+    std::cout << "All kernel results within " << MAX_RELATIVE_ERROR << " of GEOS" << std::endl;
+    return 0;
+  }
+  catch (const std::exception &e)
+  {
+    std::cerr << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -0,0 +1,114 @@
+#include "augment_metrics.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <string>
+
+#include <geos/geom/Envelope.h>
+#include <geos/geom/LinearRing.h>
+#include <geos/geom/Point.h>
+#include <geos/geom/Polygon.h>
+#include <geos/io/GeoJSONWriter.h>
+
+using namespace geos::geom;
+using namespace geos::io;
+
+namespace
+{
+  RawProperty numberProperty(const char *key, double value)
+  {
+    return {key, propertyValueJson(GeoJSONValue(value))};
+  }
+
+  /* Polygons of a Polygon or MultiPolygon; nothing for other types, like the Python stage */
+  std::vector<const Polygon *> polygonsOf(const Geometry &geometry)
+  {
+    std::vector<const Polygon *> polygons;
+    if (geometry.getGeometryTypeId() == GEOS_POLYGON)
+    {
+      polygons.push_back(static_cast<const Polygon *>(&geometry));
+    }
+    else if (geometry.getGeometryTypeId() == GEOS_MULTIPOLYGON)
+    {
+      for (size_t i = 0; i < geometry.getNumGeometries(); ++i)
+      {
+        polygons.push_back(static_cast<const Polygon *>(geometry.getGeometryN(i)));
+      }
+    }
+    return polygons;
+  }
+}
+
+AugmentMetrics computeAugmentMetrics(const Geometry &geometry, const Geometry &projected, bool geojson)
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  AugmentMetrics metrics;
+  std::vector<RawProperty> &out = metrics.properties;
+
+  /* Core measurements */
+  double area = projected.getArea();
+  metrics.area_sqm = area;
+  out.push_back(numberProperty("area_sqm", area));
+  out.push_back(numberProperty("perimeter_m", projected.getLength()));
+
+  std::vector<const Polygon *> polygons = polygonsOf(geometry);
+  size_t vertices = 0;
+  for (const Polygon *polygon : polygons)
+  {
+    vertices += polygon->getExteriorRing()->getNumPoints();
+  }
+  out.push_back(numberProperty("num_vertices", static_cast<double>(vertices)));
+  out.push_back(numberProperty("num_polygons", static_cast<double>(polygons.size())));
+
+  /* Location */
+  double centroid_lon = nan;
+  double centroid_lat = nan;
+  if (!geometry.isEmpty())
+  {
+    std::unique_ptr<Point> centroid = geometry.getCentroid();
+    centroid_lon = centroid->getX();
+    centroid_lat = centroid->getY();
+  }
+  out.push_back(numberProperty("centroid_lon", centroid_lon));
+  out.push_back(numberProperty("centroid_lat", centroid_lat));
+
+  /* Shape characteristics */
+  const Envelope *bounds = projected.getEnvelopeInternal();
+  double width = bounds->isNull() ? 0.0 : bounds->getWidth();
+  double height = bounds->isNull() ? 0.0 : bounds->getHeight();
+  out.push_back(numberProperty("bbox_width", width));
+  out.push_back(numberProperty("bbox_height", height));
+  out.push_back(numberProperty("aspect_ratio", width / height));
+
+  double convex_hull_area = projected.convexHull()->getArea();
+  out.push_back(numberProperty("convex_hull_area", convex_hull_area));
+  out.push_back(numberProperty("convexity_ratio", area / convex_hull_area));
+
+  metrics.convex_hull = geometry.convexHull();
+  std::string convex_hull_json;
+  if (geojson)
+  {
+    GeoJSONWriter writer;
+    convex_hull_json = geometryPropertyJson(writer.write(metrics.convex_hull.get()));
+  }
+  out.push_back({"convex_hull_polygon", convex_hull_json, metrics.convex_hull.get()});
+
+  /* Multi-polygon analysis; the projected parts are in the same order */
+  std::vector<double> areas;
+  for (size_t i = 0; i < polygons.size(); ++i)
+  {
+    areas.push_back(polygons.size() == 1 ? area : projected.getGeometryN(i)->getArea());
+  }
+  std::sort(areas.begin(), areas.end(), std::greater<double>());
+
+  std::vector<GeoJSONValue> area_values(areas.begin(), areas.end());
+  out.push_back({"polygon_areas_desc", propertyValueJson(GeoJSONValue(area_values))});
+  double largest = areas.empty() ? 0.0 : areas.front();
+  double smallest = areas.empty() ? 0.0 : areas.back();
+  out.push_back(numberProperty("largest_polygon_area", largest));
+  out.push_back(numberProperty("smallest_polygon_area", smallest));
+  out.push_back(numberProperty("polygon_area_ratio", smallest > 0.0 ? largest / smallest : inf));
+  return metrics;
+}
@@ -0,0 +1,32 @@
+/*
+ * The 0c_basic_augment.py fields, computed in process for --stage augment.
+ *
+ * Lengths and areas are measured in UTM 18N meters like the Python stage
+ * (the caller passes the projected geometry, so it can share the projection
+ * with --projection utm18n); the centroid and `convex_hull_polygon` stay in
+ * the input's longitude/latitude. Numbers are written as doubles, which is
+ * how they read back once the Python output has been through GeoJSONReader.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <geos/geom/Geometry.h>
+
+#include "geojson_feature.h"
+
+struct AugmentMetrics
+{
+  std::unique_ptr<geos::geom::Geometry> convex_hull; // Of the input, in its coordinates
+  double area_sqm = 0.0;                             // For --output-analysis
+  std::vector<RawProperty> properties;               // convex_hull_polygon refers to convex_hull
+};
+
+/*
+ * Metrics of `geometry`, with `projected` the same geometry in UTM 18N.
+ * The GeoJSON text of convex_hull_polygon is only produced if `geojson`.
+ */
+AugmentMetrics computeAugmentMetrics(const geos::geom::Geometry &geometry, const geos::geom::Geometry &projected,
+                                     bool geojson);
@@ -0,0 +1,80 @@
+/*
+ * Bounded queue between the stages of the batch pipeline.
+ *
+ * push() blocks while the queue is full, so a producer that runs ahead of
+ * its consumers waits instead of buffering the rest of the input; pop()
+ * blocks while it is empty. close() ends the stream: pop() returns the
+ * remaining items and then false, and push() refuses new ones, which is
+ * also how a stage that failed stops the others.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+template <typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+  BoundedQueue(const BoundedQueue &) = delete;
+  BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+  /* Wait for room and append `item`; false if the queue was closed */
+  bool push(T item)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [&]
+                   { return closed_ || items_.size() < capacity_; });
+    if (closed_)
+    {
+      return false;
+    }
+    items_.push_back(std::move(item));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /* Wait for the oldest item; false once the queue is closed and empty */
+  bool pop(T &item)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [&]
+                    { return closed_ || !items_.empty(); });
+    if (items_.empty())
+    {
+      return false;
+    }
+    item = std::move(items_.front());
+    items_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return true;
+  }
+
+  void close()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    not_full_.notify_all();
+    not_empty_.notify_all();
+  }
+
+  size_t capacity() const { return capacity_; }
+
+private:
+  size_t capacity_;
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
@@ -0,0 +1,268 @@
+#include "feature_arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include <sys/mman.h>
+
+namespace
+{
+  /*
+   * Address ranges of all live arenas, so operator delete can recognise
+   * arena memory whichever thread frees it. Slots are never reused; the
+   * bounds only ever grow and just make the common heap pointer cheap to
+   * rule out.
+   */
+  const size_t MAX_ARENAS = 256;
+
+  struct ArenaRange
+  {
+    std::atomic<uintptr_t> begin{0};
+    std::atomic<uintptr_t> end{0};
+  };
+
+  ArenaRange arena_ranges[MAX_ARENAS];
+  std::atomic<size_t> arena_count{0};
+  std::atomic<uintptr_t> arenas_lowest{UINTPTR_MAX};
+  std::atomic<uintptr_t> arenas_highest{0};
+
+  thread_local FeatureArena *current_arena = nullptr;
+
+  bool arenaOwned(const void *p)
+  {
+    if (current_arena && current_arena->owns(p))
+    {
+      return true;
+    }
+    uintptr_t address = reinterpret_cast<uintptr_t>(p);
+    if (address < arenas_lowest.load(std::memory_order_relaxed) ||
+        address >= arenas_highest.load(std::memory_order_relaxed))
+    {
+      return false;
+    }
+    size_t count = std::min(arena_count.load(std::memory_order_acquire), MAX_ARENAS);
+    for (size_t i = 0; i < count; ++i)
+    {
+      if (address >= arena_ranges[i].begin.load(std::memory_order_relaxed) &&
+          address < arena_ranges[i].end.load(std::memory_order_relaxed))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void *heapAllocate(size_t size, size_t alignment)
+  {
+    size = std::max<size_t>(size, 1);
+    for (;;)
+    {
+      void *p = nullptr;
+      if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+      {
+        p = std::malloc(size);
+      }
+      else if (posix_memalign(&p, std::max(alignment, sizeof(void *)), size) != 0)
+      {
+        p = nullptr;
+      }
+      if (p)
+      {
+        return p;
+      }
+      std::new_handler handler = std::get_new_handler();
+      if (!handler)
+      {
+        throw std::bad_alloc();
+      }
+      handler();
+    }
+  }
+
+  void *allocate(size_t size, size_t alignment)
+  {
+    if (current_arena)
+    {
+      if (void *p = current_arena->allocate(size, alignment))
+      {
+        return p;
+      }
+    }
+    return heapAllocate(size, alignment);
+  }
+
+  void *allocateOrNull(size_t size, size_t alignment) noexcept
+  {
+    try
+    {
+      return allocate(size, alignment);
+    }
+    catch (...)
+    {
+      return nullptr;
+    }
+  }
+
+  void release(void *p) noexcept
+  {
+    if (p && !arenaOwned(p))
+    {
+      std::free(p);
+    }
+  }
+
+  /* Lower (or raise) `bound` to `value` unless it is already beyond it */
+  void widenBound(std::atomic<uintptr_t> &bound, uintptr_t value, bool lower)
+  {
+    uintptr_t current = bound.load();
+    while ((lower ? value < current : value > current) && !bound.compare_exchange_weak(current, value))
+    {
+    }
+  }
+}
+
+FeatureArena::FeatureArena(size_t reserve_bytes) : capacity_(reserve_bytes)
+{
+  int flags = MAP_PRIVATE | MAP_ANON;
+#ifdef MAP_NORESERVE
+  flags |= MAP_NORESERVE;
+#endif
+  void *region = mmap(nullptr, capacity_, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (region == MAP_FAILED)
+  {
+    throw std::runtime_error("Could not reserve " + std::to_string(capacity_ >> 20) + " MB for a feature arena");
+  }
+  base_ = static_cast<char *>(region);
+
+  slot_ = arena_count.fetch_add(1);
+  if (slot_ >= MAX_ARENAS)
+  {
+    munmap(base_, capacity_);
+    throw std::runtime_error("Too many feature arenas (at most " + std::to_string(MAX_ARENAS) + ")");
+  }
+  uintptr_t begin = reinterpret_cast<uintptr_t>(base_);
+  arena_ranges[slot_].begin.store(begin);
+  arena_ranges[slot_].end.store(begin + capacity_);
+  widenBound(arenas_lowest, begin, true);
+  widenBound(arenas_highest, begin + capacity_, false);
+}
+
+FeatureArena::~FeatureArena()
+{
+  arena_ranges[slot_].begin.store(0);
+  arena_ranges[slot_].end.store(0);
+  munmap(base_, capacity_);
+}
+
+void *FeatureArena::allocate(size_t size, size_t alignment)
+{
+  /* Distinct objects need distinct addresses, even empty ones */
+  size = std::max<size_t>(size, 1);
+  size_t start = (used_ + alignment - 1) & ~(alignment - 1);
+  if (start > capacity_ || size > capacity_ - start)
+  {
+    stats_.overflow_allocations++;
+    return nullptr;
+  }
+  used_ = start + size;
+  touched_ = std::max(touched_, used_);
+  stats_.allocations++;
+  return base_ + start;
+}
+
+ArenaStats FeatureArena::reset()
+{
+  ArenaStats finished = stats_;
+  finished.peak_bytes = used_;
+  if (touched_ > RETAINED_BYTES)
+  {
+    madvise(base_ + RETAINED_BYTES, touched_ - RETAINED_BYTES, MADV_DONTNEED);
+    touched_ = RETAINED_BYTES;
+  }
+  used_ = 0;
+  stats_ = ArenaStats();
+  return finished;
+}
+
+ArenaScope::ArenaScope(FeatureArena &arena) : previous_(current_arena)
+{
+  current_arena = &arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+  current_arena = previous_;
+}
+
+ArenaPause::ArenaPause() : previous_(current_arena)
+{
+  current_arena = nullptr;
+}
+
+ArenaPause::~ArenaPause()
+{
+  current_arena = previous_;
+}
+
+/*
+ * Replacements of the global allocation functions. Outside an ArenaScope
+ * they are plain malloc/free; the only cost is the ownership check on delete.
+ */
+
+void *operator new(std::size_t size)
+{
+  return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](std::size_t size)
+{
+  return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+  return allocate(size, static_cast<size_t>(alignment));
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+  return allocateOrNull(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+  return allocateOrNull(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+  return allocateOrNull(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+  return allocateOrNull(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, std::size_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t) noexcept { release(p); }
+void operator delete(void *p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { release(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { release(p); }
+void operator delete(void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t &) noexcept { release(p); }
@@ -0,0 +1,88 @@
+/*
+ * Per-worker monotonic arenas for --arena.
+ *
+ * A hull search allocates and frees triangulations, intermediate polygons
+ * and result geometries by the thousand, and with many workers the global
+ * heap's locks become the bottleneck. While an ArenaScope is active, every
+ * operator new on that thread is served by bumping a pointer in the
+ * worker's FeatureArena and operator delete of arena memory does nothing;
+ * the whole arena is reclaimed at once by reset() after the feature.
+ *
+ * Anything that has to outlive the feature must be copied to the heap under
+ * an ArenaPause before the reset, and objects living in the arena must be
+ * destroyed before it. Allocations that don't fit in the arena's reserved
+ * address space fall back to the heap.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+/* Counters of one feature's arena use */
+struct ArenaStats
+{
+  size_t allocations = 0;          // operator new calls served by the arena
+  size_t peak_bytes = 0;           // Arena bytes in use when the feature finished (the arena never shrinks)
+  size_t overflow_allocations = 0; // Allocations that didn't fit and went to the heap
+};
+
+class FeatureArena
+{
+public:
+  /* Reserves (but doesn't commit) `reserve_bytes` of address space; throws if that fails */
+  explicit FeatureArena(size_t reserve_bytes = DEFAULT_RESERVE_BYTES);
+  ~FeatureArena();
+
+  FeatureArena(const FeatureArena &) = delete;
+  FeatureArena &operator=(const FeatureArena &) = delete;
+
+  /* `size` bytes aligned to `alignment` (a power of two), or nullptr if the arena is full */
+  void *allocate(size_t size, size_t alignment);
+
+  bool owns(const void *p) const { return p >= base_ && p < base_ + capacity_; }
+
+  /* Reclaim everything allocated since the last reset; returns what that feature used */
+  ArenaStats reset();
+
+  /* 1 GiB of address space per worker; pages are only committed when touched */
+  static constexpr size_t DEFAULT_RESERVE_BYTES = size_t(1) << 30;
+
+  /* Touched pages beyond this are returned to the OS on reset, so one huge park doesn't pin its peak */
+  static constexpr size_t RETAINED_BYTES = size_t(64) << 20;
+
+private:
+  char *base_ = nullptr;
+  size_t capacity_ = 0;
+  size_t used_ = 0;
+  size_t touched_ = 0; // High-water mark of used_ since pages were last released
+  size_t slot_ = 0;    // Position in the registry operator delete consults
+  ArenaStats stats_;
+};
+
+/* Route this thread's allocations to `arena` for the lifetime of the scope */
+class ArenaScope
+{
+public:
+  explicit ArenaScope(FeatureArena &arena);
+  ~ArenaScope();
+
+  ArenaScope(const ArenaScope &) = delete;
+  ArenaScope &operator=(const ArenaScope &) = delete;
+
+private:
+  FeatureArena *previous_;
+};
+
+/* Allocate from the heap again inside an ArenaScope, e.g. to copy results out */
+class ArenaPause
+{
+public:
+  ArenaPause();
+  ~ArenaPause();
+
+  ArenaPause(const ArenaPause &) = delete;
+  ArenaPause &operator=(const ArenaPause &) = delete;
+
+private:
+  FeatureArena *previous_;
+};
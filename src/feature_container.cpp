@@ -0,0 +1,583 @@
+#include "feature_container.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#include <geos/io/GeoJSONWriter.h> /* Brings in the vendored nlohmann JSON */
+#include <geos/io/WKBConstants.h>
+#include <geos/io/WKBWriter.h>
+
+using namespace geos::geom;
+using namespace geos::io;
+
+using json = geos_nlohmann::json;
+
+/* The format's integers are little endian, and putValue/getValue copy them as they are in memory */
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "The .wkbf container is little endian; big-endian hosts would need byte swaps in its reader and writer");
+
+const char CONTAINER_MAGIC[8] = {'W', 'K', 'B', 'F', 'E', 'A', 'T', '1'};
+const size_t CONTAINER_HEADER_SIZE = sizeof(CONTAINER_MAGIC) + 2 * sizeof(uint64_t);
+
+/* Property value tags */
+const char TAG_NULL = 'z';
+const char TAG_FALSE = 'f';
+const char TAG_TRUE = 't';
+const char TAG_NUMBER = 'n';
+const char TAG_STRING = 's';
+const char TAG_ARRAY = 'a';
+const char TAG_OBJECT = 'o';
+const char TAG_GEOMETRY = 'g';
+
+namespace
+{
+  template <typename T>
+  void putValue(std::string &out, T value)
+  {
+    out.append(reinterpret_cast<const char *>(&value), sizeof(value));
+  }
+
+  template <typename T>
+  T getValue(const char *data)
+  {
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+  }
+
+  void putString(std::string &out, std::string_view text)
+  {
+    putValue(out, static_cast<uint32_t>(text.size()));
+    out.append(text);
+  }
+
+  void putWKB(std::string &out, const Geometry &geometry)
+  {
+    std::ostringstream wkb;
+    WKBWriter writer;
+    writer.setByteOrder(WKBConstants::wkbNDR);
+    writer.write(geometry, wkb);
+    putString(out, wkb.str());
+  }
+
+  void encodeValue(std::string &out, const GeoJSONValue &value)
+  {
+    if (value.isNumber())
+    {
+      out += TAG_NUMBER;
+      putValue(out, value.getNumber());
+    }
+    else if (value.isString())
+    {
+      out += TAG_STRING;
+      putString(out, value.getString());
+    }
+    else if (value.isBoolean())
+    {
+      out += value.getBoolean() ? TAG_TRUE : TAG_FALSE;
+    }
+    else if (value.isArray())
+    {
+      out += TAG_ARRAY;
+      putValue(out, static_cast<uint32_t>(value.getArray().size()));
+      for (const GeoJSONValue &item : value.getArray())
+      {
+        encodeValue(out, item);
+      }
+    }
+    else if (value.isObject())
+    {
+      out += TAG_OBJECT;
+      putValue(out, static_cast<uint32_t>(value.getObject().size()));
+      for (const auto &entry : value.getObject())
+      {
+        putString(out, entry.first);
+        encodeValue(out, entry.second);
+      }
+    }
+    else
+    {
+      out += TAG_NULL;
+    }
+  }
+
+  /* Extra properties arrive as JSON text */
+  void encodeJson(std::string &out, const json &value)
+  {
+    if (value.is_number())
+    {
+      out += TAG_NUMBER;
+      putValue(out, value.get<double>());
+    }
+    else if (value.is_string())
+    {
+      out += TAG_STRING;
+      putString(out, value.get_ref<const std::string &>());
+    }
+    else if (value.is_boolean())
+    {
+      out += value.get<bool>() ? TAG_TRUE : TAG_FALSE;
+    }
+    else if (value.is_array())
+    {
+      out += TAG_ARRAY;
+      putValue(out, static_cast<uint32_t>(value.size()));
+      for (const json &item : value)
+      {
+        encodeJson(out, item);
+      }
+    }
+    else if (value.is_object())
+    {
+      out += TAG_OBJECT;
+      putValue(out, static_cast<uint32_t>(value.size()));
+      for (auto it = value.begin(); it != value.end(); ++it)
+      {
+        putString(out, it.key());
+        encodeJson(out, it.value());
+      }
+    }
+    else
+    {
+      out += TAG_NULL;
+    }
+  }
+
+  /* Bounds-checked reads over one record */
+  class RecordCursor
+  {
+  public:
+    explicit RecordCursor(std::string_view record) : data_(record.data()), size_(record.size()) {}
+
+    const char *take(size_t n)
+    {
+      if (n > size_ - pos_)
+      {
+        throw std::runtime_error("Corrupt feature record in container");
+      }
+      const char *start = data_ + pos_;
+      pos_ += n;
+      return start;
+    }
+
+    template <typename T>
+    T value()
+    {
+      return getValue<T>(take(sizeof(T)));
+    }
+
+    std::string_view string()
+    {
+      uint32_t size = value<uint32_t>();
+      return std::string_view(take(size), size);
+    }
+
+    char tag()
+    {
+      return *take(1);
+    }
+
+    char peekTag() const
+    {
+      if (pos_ >= size_)
+      {
+        throw std::runtime_error("Corrupt feature record in container");
+      }
+      return data_[pos_];
+    }
+
+  private:
+    const char *data_;
+    size_t size_;
+    size_t pos_ = 0;
+  };
+}
+
+FeatureContainerReader::FeatureContainerReader(const std::string &path) : file_(path)
+{
+  const char *data = file_.data();
+  if (file_.size() < CONTAINER_HEADER_SIZE || std::memcmp(data, CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC)) != 0)
+  {
+    fail("not a WKB feature container");
+  }
+
+  uint64_t feature_count = getValue<uint64_t>(data + sizeof(CONTAINER_MAGIC));
+  uint64_t index_offset = getValue<uint64_t>(data + sizeof(CONTAINER_MAGIC) + sizeof(uint64_t));
+  if (index_offset < CONTAINER_HEADER_SIZE || index_offset > file_.size() ||
+      feature_count > (file_.size() - index_offset) / sizeof(uint64_t))
+  {
+    fail("missing or truncated index (incomplete write?)");
+  }
+  index_ = data + index_offset;
+  size_ = static_cast<size_t>(feature_count);
+}
+
+void FeatureContainerReader::fail(const std::string &message) const
+{
+  throw std::runtime_error("Invalid feature container " + file_.path() + ": " + message);
+}
+
+std::string_view FeatureContainerReader::record(size_t index) const
+{
+  uint64_t offset = getValue<uint64_t>(index_ + index * sizeof(uint64_t));
+  size_t end = static_cast<size_t>(index_ - file_.data());
+  if (offset < CONTAINER_HEADER_SIZE || offset + sizeof(uint32_t) > end)
+  {
+    fail("record " + std::to_string(index) + " is out of bounds");
+  }
+  uint32_t size = getValue<uint32_t>(file_.data() + offset);
+  if (size > end - offset - sizeof(uint32_t))
+  {
+    fail("record " + std::to_string(index) + " is out of bounds");
+  }
+  return std::string_view(file_.data() + offset + sizeof(uint32_t), size);
+}
+
+bool FeatureContainerReader::next(std::string_view &record_bytes)
+{
+  if (count_ >= size_)
+  {
+    return false;
+  }
+  record_bytes = record(count_);
+  count_++;
+  return true;
+}
+
+FeatureContainerWriter::FeatureContainerWriter(const std::string &path) : file_(path)
+{
+  /* Placeholder header; the real one is written by close() */
+  file_.append(std::string(CONTAINER_HEADER_SIZE, '\0'));
+}
+
+void FeatureContainerWriter::write(std::string_view record)
+{
+  offsets_.push_back(file_.offset());
+  std::string size;
+  putValue(size, static_cast<uint32_t>(record.size()));
+  file_.append(size);
+  file_.append(record);
+}
+
+void FeatureContainerWriter::close()
+{
+  uint64_t index_offset = file_.offset();
+  std::string index;
+  index.reserve(offsets_.size() * sizeof(uint64_t));
+  for (uint64_t offset : offsets_)
+  {
+    putValue(index, offset);
+  }
+  file_.append(index);
+
+  std::string header(CONTAINER_MAGIC, sizeof(CONTAINER_MAGIC));
+  putValue(header, static_cast<uint64_t>(offsets_.size()));
+  putValue(header, index_offset);
+  file_.patch(0, header);
+  file_.close();
+}
+
+std::string encodeContainerRecord(const Geometry *geometry,
+                                  const std::map<std::string, GeoJSONValue> &properties,
+                                  const std::vector<RawProperty> &extra_properties,
+                                  const std::string &id)
+{
+  std::string out;
+  putString(out, id);
+  if (geometry)
+  {
+    putWKB(out, *geometry);
+  }
+  else
+  {
+    putValue(out, static_cast<uint32_t>(0));
+  }
+
+  /* Extras replace properties with the same key */
+  auto is_replaced = [&](const std::string &key)
+  {
+    for (const RawProperty &extra : extra_properties)
+    {
+      if (extra.key == key)
+      {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  uint32_t count = static_cast<uint32_t>(extra_properties.size());
+  for (const auto &entry : properties)
+  {
+    count += is_replaced(entry.first) ? 0 : 1;
+  }
+  putValue(out, count);
+
+  for (const auto &entry : properties)
+  {
+    if (!is_replaced(entry.first))
+    {
+      putString(out, entry.first);
+      encodeValue(out, entry.second);
+    }
+  }
+  for (const RawProperty &extra : extra_properties)
+  {
+    putString(out, extra.key);
+    if (extra.geometry)
+    {
+      out += TAG_GEOMETRY;
+      putWKB(out, *extra.geometry);
+    }
+    else
+    {
+      encodeJson(out, json::parse(extra.json));
+    }
+  }
+  return out;
+}
+
+ContainerRecordDecoder::ContainerRecordDecoder(const GeometryFactory &factory) : wkb_reader_(factory) {}
+
+namespace
+{
+  GeoJSONValue decodeValue(RecordCursor &cursor, WKBReader &wkb_reader)
+  {
+    char tag = cursor.tag();
+    switch (tag)
+    {
+    case TAG_NULL:
+      return GeoJSONValue();
+    case TAG_FALSE:
+      return GeoJSONValue(false);
+    case TAG_TRUE:
+      return GeoJSONValue(true);
+    case TAG_NUMBER:
+      return GeoJSONValue(cursor.value<double>());
+    case TAG_STRING:
+      return GeoJSONValue(std::string(cursor.string()));
+    case TAG_ARRAY:
+    {
+      uint32_t count = cursor.value<uint32_t>();
+      std::vector<GeoJSONValue> array;
+      for (uint32_t i = 0; i < count; ++i)
+      {
+        array.push_back(decodeValue(cursor, wkb_reader));
+      }
+      return GeoJSONValue(array);
+    }
+    case TAG_OBJECT:
+    {
+      uint32_t count = cursor.value<uint32_t>();
+      std::map<std::string, GeoJSONValue> object;
+      for (uint32_t i = 0; i < count; ++i)
+      {
+        std::string key(cursor.string());
+        object[key] = decodeValue(cursor, wkb_reader);
+      }
+      return GeoJSONValue(object);
+    }
+    case TAG_GEOMETRY:
+    {
+      /* GeoJSON properties can't hold geometries: expand to the GeoJSON geometry object */
+      std::string_view wkb = cursor.string();
+      auto geometry = wkb_reader.read(reinterpret_cast<const unsigned char *>(wkb.data()), wkb.size());
+      GeoJSONWriter writer;
+      return propertyValueFromJson(writer.write(geometry.get()));
+    }
+    default:
+      throw std::runtime_error("Corrupt feature record in container: unknown value tag");
+    }
+  }
+}
+
+GeoJSONFeature ContainerRecordDecoder::decode(std::string_view record)
+{
+  RecordCursor cursor(record);
+  std::string id(cursor.string());
+
+  std::unique_ptr<Geometry> geometry;
+  std::string_view wkb = cursor.string();
+  if (!wkb.empty())
+  {
+    geometry = wkb_reader_.read(reinterpret_cast<const unsigned char *>(wkb.data()), wkb.size());
+  }
+
+  std::map<std::string, GeoJSONValue> properties;
+  uint32_t count = cursor.value<uint32_t>();
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    std::string key(cursor.string());
+    properties[key] = decodeValue(cursor, wkb_reader_);
+  }
+  return GeoJSONFeature(std::move(geometry), std::move(properties), std::move(id));
+}
+
+namespace
+{
+  /* Expands `envelope` by the coordinates of one WKB geometry, without building it */
+  class WKBEnvelopeWalker
+  {
+  public:
+    WKBEnvelopeWalker(std::string_view wkb, Envelope &envelope) : cursor_(wkb), envelope_(envelope) {}
+
+    void geometry()
+    {
+      bool little_endian = cursor_.value<uint8_t>() == 1;
+      uint32_t type = integer(little_endian);
+
+      /* EWKB flags (what GEOS writes for Z/M/SRID) or ISO type offsets */
+      size_t dimensions = 2;
+      if (type & 0x80000000u)
+      {
+        dimensions++;
+      }
+      if (type & 0x40000000u)
+      {
+        dimensions++;
+      }
+      if (type & 0x20000000u)
+      {
+        integer(little_endian); // SRID
+      }
+      type &= 0x0fffffffu;
+      if (type >= 1000)
+      {
+        dimensions += type / 1000 == 3 ? 2 : 1;
+        type %= 1000;
+      }
+
+      switch (type)
+      {
+      case 1: // Point
+        points(1, dimensions, little_endian);
+        break;
+      case 2: // LineString
+        points(integer(little_endian), dimensions, little_endian);
+        break;
+      case 3: // Polygon
+        for (uint32_t rings = integer(little_endian); rings > 0; --rings)
+        {
+          points(integer(little_endian), dimensions, little_endian);
+        }
+        break;
+      case 4: // MultiPoint
+      case 5: // MultiLineString
+      case 6: // MultiPolygon
+      case 7: // GeometryCollection
+        for (uint32_t parts = integer(little_endian); parts > 0; --parts)
+        {
+          geometry();
+        }
+        break;
+      default:
+        throw std::runtime_error("Corrupt feature record in container: unknown WKB geometry type");
+      }
+    }
+
+  private:
+    uint32_t integer(bool little_endian)
+    {
+      uint32_t v = cursor_.value<uint32_t>();
+      return little_endian ? v : __builtin_bswap32(v);
+    }
+
+    double coordinate(bool little_endian)
+    {
+      uint64_t bits = cursor_.value<uint64_t>();
+      if (!little_endian)
+      {
+        bits = __builtin_bswap64(bits);
+      }
+      double v;
+      std::memcpy(&v, &bits, sizeof(v));
+      return v;
+    }
+
+    void points(uint32_t count, size_t dimensions, bool little_endian)
+    {
+      for (uint32_t i = 0; i < count; ++i)
+      {
+        double x = coordinate(little_endian);
+        double y = coordinate(little_endian);
+        cursor_.take((dimensions - 2) * sizeof(double));
+        if (!std::isnan(x) && !std::isnan(y)) // An empty point is NaN, NaN
+        {
+          envelope_.expandToInclude(x, y);
+        }
+      }
+    }
+
+    RecordCursor cursor_;
+    Envelope &envelope_;
+  };
+
+  void skipValue(RecordCursor &cursor)
+  {
+    switch (cursor.tag())
+    {
+    case TAG_NULL:
+    case TAG_FALSE:
+    case TAG_TRUE:
+      return;
+    case TAG_NUMBER:
+      cursor.take(sizeof(double));
+      return;
+    case TAG_STRING:
+    case TAG_GEOMETRY:
+      cursor.string();
+      return;
+    case TAG_ARRAY:
+      for (uint32_t count = cursor.value<uint32_t>(); count > 0; --count)
+      {
+        skipValue(cursor);
+      }
+      return;
+    case TAG_OBJECT:
+      for (uint32_t count = cursor.value<uint32_t>(); count > 0; --count)
+      {
+        cursor.string();
+        skipValue(cursor);
+      }
+      return;
+    default:
+      throw std::runtime_error("Corrupt feature record in container: unknown value tag");
+    }
+  }
+}
+
+RecordSummary summarizeContainerRecord(std::string_view record, const std::vector<std::string> &keys)
+{
+  RecordSummary summary;
+  RecordCursor cursor(record);
+  cursor.string(); // id
+
+  std::string_view wkb = cursor.string();
+  if (!wkb.empty())
+  {
+    WKBEnvelopeWalker(wkb, summary.envelope).geometry();
+  }
+
+  for (uint32_t count = cursor.value<uint32_t>(); count > 0; --count)
+  {
+    std::string_view key = cursor.string();
+    if (std::find(keys.begin(), keys.end(), key) == keys.end())
+    {
+      skipValue(cursor);
+      continue;
+    }
+    if (cursor.peekTag() == TAG_STRING)
+    {
+      cursor.tag();
+      summary.strings[std::string(key)] = std::string(cursor.string());
+    }
+    else
+    {
+      skipValue(cursor);
+    }
+  }
+  return summary;
+}
@@ -0,0 +1,103 @@
+/*
+ * WKB feature container (.wkbf): a binary, indexed alternative to GeoJSON
+ * for the intermediate files passed between stages.
+ *
+ * Geometries are stored as WKB and properties in a compact tagged binary
+ * encoding, so reading a feature back costs a memcpy-style decode instead
+ * of number parsing, and the record index lets a reader jump to any feature
+ * without scanning the ones before it.
+ *
+ *   header   "WKBFEAT1" | uint64 feature count | uint64 index offset
+ *   records  uint32 size | record, one per feature
+ *   index    uint64 record offset, one per feature
+ *
+ *   record   string id | uint32 size | WKB (NDR) | uint32 count | (string key | value)...
+ *   value    tag byte, then: 'z' null, 'f' false, 't' true, 'n' double,
+ *            's' string, 'a' uint32 count | value..., 'o' uint32 count |
+ *            (string key | value)..., 'g' uint32 size | WKB (NDR)
+ *   string   uint32 size | bytes
+ *
+ * All integers are little endian. The header is written last, so a file
+ * left behind by an interrupted run is rejected rather than read short.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <geos/geom/Geometry.h>
+#include <geos/geom/GeometryFactory.h>
+#include <geos/io/GeoJSON.h>
+#include <geos/io/WKBReader.h>
+
+#include "feature_io.h"
+#include "file_io.h"
+#include "geojson_feature.h"
+
+class FeatureContainerReader : public FeatureReader
+{
+public:
+  explicit FeatureContainerReader(const std::string &path);
+
+  bool next(std::string_view &record) override;
+
+  /* Number of records returned by next() so far */
+  size_t count() const override { return count_; }
+
+  /* Number of records in the file */
+  size_t size() const { return size_; }
+
+  /* Random access through the index */
+  std::string_view record(size_t index) const;
+
+private:
+  [[noreturn]] void fail(const std::string &message) const;
+
+  MappedFile file_;
+  const char *index_ = nullptr;
+  size_t size_ = 0;
+  size_t count_ = 0;
+};
+
+class FeatureContainerWriter : public FeatureWriter
+{
+public:
+  explicit FeatureContainerWriter(const std::string &path);
+
+  void write(std::string_view record) override;
+
+  /* Write the index and header and close the file */
+  void close() override;
+
+  size_t count() const override { return offsets_.size(); }
+
+private:
+  OutputFile file_;
+  std::vector<uint64_t> offsets_;
+};
+
+/* Encode a feature from borrowed geometry and properties */
+std::string encodeContainerRecord(const geos::geom::Geometry *geometry,
+                                  const std::map<std::string, geos::io::GeoJSONValue> &properties,
+                                  const std::vector<RawProperty> &extra_properties,
+                                  const std::string &id);
+
+/* Envelope (walked from the WKB) and selected string properties of a record */
+RecordSummary summarizeContainerRecord(std::string_view record, const std::vector<std::string> &keys);
+
+/* Decodes records into features; one per thread, like the WKBReader it wraps */
+class ContainerRecordDecoder
+{
+public:
+  explicit ContainerRecordDecoder(const geos::geom::GeometryFactory &factory);
+
+  geos::io::GeoJSONFeature decode(std::string_view record);
+
+private:
+  geos::io::WKBReader wkb_reader_;
+};
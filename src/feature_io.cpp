@@ -0,0 +1,140 @@
+#include "feature_io.h"
+
+#include <stdexcept>
+
+#include <geos/io/GeoJSONReader.h>
+
+#include "feature_container.h"
+#include "geojson_feature.h"
+#include "geojson_stream.h"
+
+using namespace geos::geom;
+using namespace geos::io;
+
+const std::string CONTAINER_EXTENSION = ".wkbf";
+
+FeatureFormat featureFormatForPath(const std::string &path)
+{
+  if (path.size() >= CONTAINER_EXTENSION.size() &&
+      path.compare(path.size() - CONTAINER_EXTENSION.size(), CONTAINER_EXTENSION.size(), CONTAINER_EXTENSION) == 0)
+  {
+    return FeatureFormat::Container;
+  }
+  return FeatureFormat::GeoJSON;
+}
+
+std::unique_ptr<FeatureReader> openFeatureReader(const std::string &path)
+{
+  if (featureFormatForPath(path) == FeatureFormat::Container)
+  {
+    return std::make_unique<FeatureContainerReader>(path);
+  }
+  return std::make_unique<GeoJSONFeatureStream>(path);
+}
+
+std::unique_ptr<FeatureWriter> openFeatureWriter(const std::string &path)
+{
+  if (featureFormatForPath(path) == FeatureFormat::Container)
+  {
+    return std::make_unique<FeatureContainerWriter>(path);
+  }
+  return std::make_unique<FeatureCollectionWriter>(path);
+}
+
+FeatureDecoder::FeatureDecoder(FeatureFormat format, const GeometryFactory &factory) : format_(format)
+{
+  if (format_ == FeatureFormat::Container)
+  {
+    container_decoder_ = std::make_unique<ContainerRecordDecoder>(factory);
+  }
+  else
+  {
+    geojson_reader_ = std::make_unique<GeoJSONReader>(factory);
+  }
+}
+
+FeatureDecoder::~FeatureDecoder() = default;
+
+void FeatureDecoder::passThroughProperties(std::vector<std::string> keys)
+{
+  if (format_ != FeatureFormat::GeoJSON)
+  {
+    throw std::runtime_error("Raw properties can only be passed through from GeoJSON input");
+  }
+  passthrough_ = true;
+  passthrough_keys_ = std::move(keys);
+}
+
+GeoJSONFeatureCollection FeatureDecoder::decode(std::string_view record, std::string_view *raw_properties)
+{
+  if (raw_properties)
+  {
+    *raw_properties = std::string_view();
+  }
+  if (format_ == FeatureFormat::Container)
+  {
+    std::vector<GeoJSONFeature> features;
+    features.push_back(container_decoder_->decode(record));
+    return GeoJSONFeatureCollection(std::move(features));
+  }
+
+  /* Only the properties the caller reads are parsed; the rest is passed through as text */
+  PropertySplit split;
+  if (passthrough_)
+  {
+    split = splitFeatureProperties(record, passthrough_keys_);
+    if (raw_properties)
+    {
+      *raw_properties = split.raw;
+    }
+    if (!split.raw.empty())
+    {
+      record = split.reduced;
+    }
+  }
+
+  /* Wrapped in a collection so the reader's FeatureCollection path does the parsing */
+  std::string collection_json;
+  collection_json.reserve(record.size() + FEATURE_COLLECTION_HEADER.size() + FEATURE_COLLECTION_FOOTER.size());
+  collection_json.append(FEATURE_COLLECTION_HEADER);
+  collection_json.append(record);
+  collection_json.append(FEATURE_COLLECTION_FOOTER);
+  GeoJSONFeatureCollection parsed = geojson_reader_->readFeatures(collection_json);
+  if (parsed.getFeatures().size() != 1)
+  {
+    throw std::runtime_error("Expected a single GeoJSON feature");
+  }
+  return parsed;
+}
+
+std::string encodeFeature(FeatureFormat format,
+                          const Geometry *geometry,
+                          std::string_view geometry_json,
+                          const std::map<std::string, GeoJSONValue> &properties,
+                          const std::vector<RawProperty> &extra_properties,
+                          const std::string &id,
+                          std::string_view raw_properties)
+{
+  if (format == FeatureFormat::Container)
+  {
+    if (!raw_properties.empty())
+    {
+      throw std::runtime_error("Raw properties can only be written to GeoJSON outputs");
+    }
+    return encodeContainerRecord(geometry, properties, extra_properties, id);
+  }
+  if (!raw_properties.empty())
+  {
+    return writeFeatureJson(geometry_json, raw_properties, extra_properties, id);
+  }
+  return writeFeatureJson(geometry_json, properties, extra_properties, id);
+}
+
+RecordSummary summarizeRecord(FeatureFormat format, std::string_view record, const std::vector<std::string> &keys)
+{
+  if (format == FeatureFormat::Container)
+  {
+    return summarizeContainerRecord(record, keys);
+  }
+  return summarizeGeoJSONFeature(record, keys);
+}
@@ -0,0 +1,130 @@
+/*
+ * Format-independent feature input and output.
+ *
+ * A file's format is chosen by its extension: ".wkbf" files use the binary
+ * WKB feature container (src/feature_container.h), anything else is GeoJSON.
+ * Readers hand out raw records that are decoded on the worker threads;
+ * writers take records that were encoded there.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <geos/geom/Envelope.h>
+#include <geos/geom/Geometry.h>
+#include <geos/geom/GeometryFactory.h>
+#include <geos/io/GeoJSON.h>
+
+struct RawProperty;
+class ContainerRecordDecoder;
+
+namespace geos
+{
+  namespace io
+  {
+    class GeoJSONReader;
+  }
+}
+
+enum class FeatureFormat
+{
+  GeoJSON,
+  Container
+};
+
+FeatureFormat featureFormatForPath(const std::string &path);
+
+/* Source of raw feature records, consumed in order */
+class FeatureReader
+{
+public:
+  virtual ~FeatureReader() = default;
+
+  /* Next record; false once the input is exhausted */
+  virtual bool next(std::string_view &record) = 0;
+
+  /* Number of records returned so far */
+  virtual size_t count() const = 0;
+};
+
+/* Sink for encoded feature records, written in order */
+class FeatureWriter
+{
+public:
+  virtual ~FeatureWriter() = default;
+
+  virtual void write(std::string_view record) = 0;
+
+  /* Finish the file; a writer destroyed without close() leaves it incomplete */
+  virtual void close() = 0;
+
+  /* Number of records written so far */
+  virtual size_t count() const = 0;
+};
+
+std::unique_ptr<FeatureReader> openFeatureReader(const std::string &path);
+std::unique_ptr<FeatureWriter> openFeatureWriter(const std::string &path);
+
+/* Turns records of one format back into features; one per worker thread */
+class FeatureDecoder
+{
+public:
+  FeatureDecoder(FeatureFormat format, const geos::geom::GeometryFactory &factory);
+  ~FeatureDecoder();
+
+  /*
+   * Raw property passthrough (--raw-properties, GeoJSON only): decode only
+   * the properties named in `keys`, and have decode() report the text of
+   * the record's whole properties object instead.
+   */
+  void passThroughProperties(std::vector<std::string> keys);
+
+  /*
+   * The decoded feature, as the only member of a collection: GeoJSONReader
+   * only hands features out that way, and copying one out would clone its
+   * geometry. With passthrough, `raw_properties` is set to a span of
+   * `record` (empty if the feature has no properties object).
+   */
+  geos::io::GeoJSONFeatureCollection decode(std::string_view record, std::string_view *raw_properties = nullptr);
+
+private:
+  FeatureFormat format_;
+  bool passthrough_ = false;
+  std::vector<std::string> passthrough_keys_;
+  std::unique_ptr<geos::io::GeoJSONReader> geojson_reader_;
+  std::unique_ptr<ContainerRecordDecoder> container_decoder_;
+};
+
+/*
+ * Encode a feature from borrowed geometry and properties. GeoJSON output
+ * uses `geometry_json` (GeoJSONWriter::write(geometry)) and the extras' JSON;
+ * the container encodes `geometry` and geometry-valued extras as WKB.
+ * Non-empty `raw_properties` (from a passthrough decoder) are written in
+ * place of `properties`, which is only possible for GeoJSON.
+ */
+std::string encodeFeature(FeatureFormat format,
+                          const geos::geom::Geometry *geometry,
+                          std::string_view geometry_json,
+                          const std::map<std::string, geos::io::GeoJSONValue> &properties,
+                          const std::vector<RawProperty> &extra_properties,
+                          const std::string &id,
+                          std::string_view raw_properties = {});
+
+/*
+ * What feature selection looks at, read from a raw record without building
+ * the geometry: its envelope and the string values of some properties.
+ */
+struct RecordSummary
+{
+  geos::geom::Envelope envelope;                // Null for empty geometries
+  std::map<std::string, std::string> strings;   // Requested properties that hold strings
+};
+
+/* Summarize a record, keeping the string values of `keys` */
+RecordSummary summarizeRecord(FeatureFormat format, std::string_view record, const std::vector<std::string> &keys);
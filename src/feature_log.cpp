@@ -0,0 +1,48 @@
+#include "feature_log.h"
+
+#include <geos/io/GeoJSONWriter.h> /* Brings in the vendored nlohmann JSON */
+
+using ordered_json = geos_nlohmann::ordered_json;
+
+FeatureLog::FeatureLog(const std::string &path) : file_(path) {}
+
+void FeatureLog::write(const FeatureProfile &profile, bool tiny_removed, bool has_issue, std::string_view messages)
+{
+  ordered_json entry;
+  entry["index"] = profile.index;
+  entry["id"] = profile.id;
+  entry["name"] = profile.name;
+  entry["hulled"] = profile.hulled;
+  if (profile.hulled)
+  {
+    entry["cache_hit"] = profile.cache_hit;
+    entry["reused"] = profile.reused;
+    entry["timed_out"] = profile.timed_out;
+    entry["attempts"] = profile.attempts;
+    entry["threshold_m"] = profile.threshold_m;
+  }
+  entry["tiny_removed"] = tiny_removed;
+  entry["multi_polygon"] = has_issue;
+  entry["ms"] = profile.total_ms;
+
+  ordered_json lines = ordered_json::array();
+  while (!messages.empty())
+  {
+    size_t end = messages.find('\n');
+    std::string_view line = messages.substr(0, end);
+    if (!line.empty())
+    {
+      lines.push_back(std::string(line));
+    }
+    if (end == std::string_view::npos)
+    {
+      break;
+    }
+    messages.remove_prefix(end + 1);
+  }
+  entry["messages"] = std::move(lines);
+
+  std::string text = entry.dump(-1, ' ', false, ordered_json::error_handler_t::replace);
+  text += '\n';
+  file_.append(text);
+}
@@ -0,0 +1,35 @@
+/*
+ * Structured per-feature log for --log.
+ *
+ * One JSON object per line and feature, in input order, written through a
+ * large buffer instead of flushing to the console line by line.
+ */
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "file_io.h"
+#include "profile_report.h"
+
+enum class LogLevel
+{
+  Quiet,   // Summary counts and warnings only
+  Normal,  // Plus progress and features that needed several attempts
+  Verbose  // Plus every per-feature diagnostic (names, thresholds tried)
+};
+
+class FeatureLog
+{
+public:
+  explicit FeatureLog(const std::string &path);
+
+  /* `messages` holds the feature's diagnostics, one per line */
+  void write(const FeatureProfile &profile, bool tiny_removed, bool has_issue, std::string_view messages);
+
+  void close() { file_.close(); }
+
+private:
+  OutputFile file_;
+};
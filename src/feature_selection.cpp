@@ -0,0 +1,132 @@
+#include "feature_selection.h"
+
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <geos/index/strtree/TemplateSTRtree.h>
+
+#include "feature_io.h"
+
+using namespace geos::geom;
+using geos::index::strtree::TemplateSTRtree;
+
+/* Properties the criteria look at */
+const std::vector<std::string> SELECTION_KEYS = {":id", "eapply", "borough"};
+
+void loadNameList(const std::string &path, std::set<std::string> &names)
+{
+  std::ifstream file(path);
+  if (!file.is_open())
+  {
+    throw std::runtime_error("Could not open file: " + path);
+  }
+  std::string line;
+  while (std::getline(file, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+    if (!line.empty())
+    {
+      names.insert(line);
+    }
+  }
+}
+
+Envelope parseBoundingBox(const std::string &text)
+{
+  std::istringstream stream(text);
+  double values[4];
+  char comma;
+  for (int i = 0; i < 4; ++i)
+  {
+    if (!(stream >> values[i]) || (i < 3 && !(stream >> comma && comma == ',')))
+    {
+      throw std::runtime_error("Invalid bounding box (expected min_lon,min_lat,max_lon,max_lat): " + text);
+    }
+  }
+  if (values[0] > values[2] || values[1] > values[3])
+  {
+    throw std::runtime_error("Invalid bounding box (min greater than max): " + text);
+  }
+  return Envelope(values[0], values[2], values[1], values[3]);
+}
+
+std::string parseBorough(const std::string &text)
+{
+  std::string name;
+  for (char c : text)
+  {
+    if (c != ' ' && c != '_' && c != '-')
+    {
+      name += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+  }
+  if (name == "b" || name == "brooklyn")
+  {
+    return "B";
+  }
+  if (name == "m" || name == "manhattan")
+  {
+    return "M";
+  }
+  if (name == "q" || name == "queens")
+  {
+    return "Q";
+  }
+  if (name == "r" || name == "statenisland")
+  {
+    return "R";
+  }
+  if (name == "x" || name == "bronx" || name == "thebronx")
+  {
+    return "X";
+  }
+  throw std::runtime_error("Unknown borough: " + text);
+}
+
+FeatureSelection::FeatureSelection(const std::string &path, const SelectionCriteria &criteria)
+{
+  FeatureFormat format = featureFormatForPath(path);
+  std::unique_ptr<FeatureReader> reader = openFeatureReader(path);
+  TemplateSTRtree<size_t> tree;
+
+  std::string_view record;
+  while (reader->next(record))
+  {
+    size_t ordinal = selected_.size();
+    RecordSummary summary = summarizeRecord(format, record, SELECTION_KEYS);
+
+    auto property = [&](const std::string &key) -> const std::string *
+    {
+      auto it = summary.strings.find(key);
+      return it == summary.strings.end() ? nullptr : &it->second;
+    };
+    const std::string *name = property("eapply");
+    const std::string *borough = property("borough");
+
+    bool selected = (criteria.names.empty() || (name && criteria.names.count(*name) > 0)) &&
+                    (criteria.boroughs.empty() || (borough && criteria.boroughs.count(*borough) > 0));
+    selected_.push_back(selected && criteria.bboxes.empty());
+    owned_.push_back(shardOf(criteria.shard, summary, ordinal) == criteria.shard.index);
+    if (selected && !criteria.bboxes.empty() && !summary.envelope.isNull())
+    {
+      tree.insert(summary.envelope, ordinal);
+    }
+  }
+
+  for (const Envelope &bbox : criteria.bboxes)
+  {
+    tree.query(bbox, [&](size_t ordinal)
+               { selected_[ordinal] = true; });
+  }
+
+  for (size_t ordinal = 0; ordinal < selected_.size(); ++ordinal)
+  {
+    selected_count_ += contains(ordinal);
+    owned_count_ += owns(ordinal);
+  }
+}
@@ -0,0 +1,62 @@
+/*
+ * Runtime feature selection by name, borough and bounding box, and the
+ * features of one --shard.
+ *
+ * Before processing, one pass over the raw input records summarizes each
+ * feature (envelope, "eapply" and "borough") without building geometries,
+ * and the envelopes go into an STRtree that answers the bounding-box
+ * queries. Workers then skip unselected records without decoding them.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <geos/geom/Envelope.h>
+
+#include "feature_shard.h"
+
+struct SelectionCriteria
+{
+  std::set<std::string> names;                  // "eapply" values (empty = any)
+  std::set<std::string> boroughs;               // "borough" codes: B, M, Q, R, X (empty = any)
+  std::vector<geos::geom::Envelope> bboxes;     // Envelope must intersect one of them (empty = anywhere)
+  ShardSpec shard;                              // Only this shard's features (count 1 = all)
+
+  bool empty() const { return names.empty() && boroughs.empty() && bboxes.empty() && !shard.enabled(); }
+};
+
+/* Add the non-empty lines of `path` to `names` */
+void loadNameList(const std::string &path, std::set<std::string> &names);
+
+/* "min_lon,min_lat,max_lon,max_lat" */
+geos::geom::Envelope parseBoundingBox(const std::string &text);
+
+/* Borough code from a code or name ("Q", "queens", "Staten Island", ...) */
+std::string parseBorough(const std::string &text);
+
+class FeatureSelection
+{
+public:
+  /* Scans every record of `path`; all criteria must match */
+  FeatureSelection(const std::string &path, const SelectionCriteria &criteria);
+
+  /* Selected and in the shard */
+  bool contains(size_t ordinal) const { return owns(ordinal) && selected_[ordinal]; }
+
+  /* In the shard; features of other shards are left out even with --keep-unselected */
+  bool owns(size_t ordinal) const { return ordinal < owned_.size() && owned_[ordinal]; }
+
+  size_t selectedCount() const { return selected_count_; }
+  size_t ownedCount() const { return owned_count_; }
+  size_t totalCount() const { return selected_.size(); }
+
+private:
+  std::vector<bool> selected_;
+  std::vector<bool> owned_;
+  size_t selected_count_ = 0;
+  size_t owned_count_ = 0;
+};
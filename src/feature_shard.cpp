@@ -0,0 +1,226 @@
+#include "feature_shard.h"
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+/* Tile size for --shard I/N:tile, about 5.5 by 4.2 km at NYC's latitude */
+const double SHARD_TILE_DEGREES = 0.05;
+
+namespace
+{
+  uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 14695981039346656037ull)
+  {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+    return hash;
+  }
+
+  bool parseCount(const std::string &text, size_t &count)
+  {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+    {
+      return false;
+    }
+    count = std::stoul(text);
+    return count > 0;
+  }
+}
+
+std::string ShardSpec::label() const
+{
+  return "shard-" + std::to_string(index + 1) + "-of-" + std::to_string(count);
+}
+
+std::string ShardSpec::describe() const
+{
+  return std::to_string(index + 1) + "/" + std::to_string(count) + (key == ShardKey::Tile ? " by tile" : " by :id");
+}
+
+ShardSpec parseShardSpec(const std::string &text)
+{
+  ShardSpec spec;
+  size_t slash = text.find('/');
+  size_t colon = text.find(':');
+  std::string key = colon == std::string::npos ? "id" : text.substr(colon + 1);
+  size_t index = 0;
+  bool valid = slash != std::string::npos && parseCount(text.substr(0, slash), index) &&
+               parseCount(text.substr(slash + 1, colon == std::string::npos ? colon : colon - slash - 1), spec.count) &&
+               index <= spec.count && (key == "id" || key == "tile");
+  if (!valid)
+  {
+    throw std::runtime_error("Invalid value for --shard (expected I/N[:id|tile] with 1 <= I <= N): " + text);
+  }
+  spec.index = index - 1;
+  spec.key = key == "tile" ? ShardKey::Tile : ShardKey::Id;
+  return spec;
+}
+
+size_t shardOf(const ShardSpec &spec, const RecordSummary &summary, size_t ordinal)
+{
+  uint64_t hash = 0;
+  if (spec.key == ShardKey::Tile && !summary.envelope.isNull())
+  {
+    /* Tile column and row as integers, so the hash doesn't depend on how the center rounds */
+    double center_x = (summary.envelope.getMinX() + summary.envelope.getMaxX()) / 2.0;
+    double center_y = (summary.envelope.getMinY() + summary.envelope.getMaxY()) / 2.0;
+    int64_t tile[2] = {static_cast<int64_t>(std::floor(center_x / SHARD_TILE_DEGREES)),
+                       static_cast<int64_t>(std::floor(center_y / SHARD_TILE_DEGREES))};
+    hash = fnv1a(tile, sizeof(tile));
+  }
+  else
+  {
+    auto id = summary.strings.find(":id");
+    if (id == summary.strings.end())
+    {
+      return ordinal % spec.count;
+    }
+    hash = fnv1a(id->second.data(), id->second.size());
+  }
+  return static_cast<size_t>(hash % spec.count);
+}
+
+std::string shardOutputPath(const std::string &path, const ShardSpec &spec)
+{
+  size_t slash = path.find_last_of('/');
+  size_t dot = path.find_last_of('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash) || dot == slash + 1)
+  {
+    return path + "." + spec.label();
+  }
+  return path.substr(0, dot) + "." + spec.label() + path.substr(dot);
+}
+
+std::string shardIndexPath(const std::string &shard_hulls_path)
+{
+  return shard_hulls_path + ".index";
+}
+
+void writeShardIndex(const std::string &path, const ShardSpec &spec, size_t input_features,
+                     const std::vector<size_t> &ordinals)
+{
+  std::ofstream file(path);
+  if (!file.is_open())
+  {
+    throw std::runtime_error("Could not open file: " + path);
+  }
+  file << "shard " << spec.index + 1 << "/" << spec.count << " of " << input_features << " features\n";
+  for (size_t ordinal : ordinals)
+  {
+    file << ordinal << "\n";
+  }
+  if (!file.flush())
+  {
+    throw std::runtime_error("Could not write file: " + path);
+  }
+}
+
+ShardIndex readShardIndex(const std::string &path, const ShardSpec &spec)
+{
+  std::ifstream file(path);
+  if (!file.is_open())
+  {
+    throw std::runtime_error("Could not open shard index: " + path);
+  }
+  ShardIndex index;
+  std::string header;
+  std::getline(file, header);
+  std::istringstream fields(header);
+  std::string word, of, features;
+  size_t shard = 0, count = 0;
+  char slash = 0;
+  if (!(fields >> word >> shard >> slash >> count >> of >> index.input_features >> features) || word != "shard" ||
+      slash != '/' || of != "of" || features != "features")
+  {
+    throw std::runtime_error("Malformed shard index: " + path);
+  }
+  if (shard != spec.index + 1 || count != spec.count)
+  {
+    throw std::runtime_error("Shard index " + path + " is for shard " + std::to_string(shard) + "/" +
+                             std::to_string(count) + ", expected " + std::to_string(spec.index + 1) + "/" +
+                             std::to_string(spec.count));
+  }
+  size_t ordinal = 0;
+  while (file >> ordinal)
+  {
+    if (ordinal >= index.input_features || (!index.ordinals.empty() && ordinal <= index.ordinals.back()))
+    {
+      throw std::runtime_error("Malformed shard index (ordinals out of order): " + path);
+    }
+    index.ordinals.push_back(ordinal);
+  }
+  if (!file.eof())
+  {
+    throw std::runtime_error("Malformed shard index: " + path);
+  }
+  return index;
+}
+
+size_t mergeShardOutputs(const std::string &path, const std::vector<ShardIndex> &indexes)
+{
+  ShardSpec spec;
+  spec.count = indexes.size();
+  std::vector<std::unique_ptr<FeatureReader>> readers;
+  for (spec.index = 0; spec.index < spec.count; ++spec.index)
+  {
+    if (indexes[spec.index].input_features != indexes[0].input_features)
+    {
+      throw std::runtime_error("Shards " + std::to_string(spec.index + 1) + " and 1 were run on different inputs (" +
+                               std::to_string(indexes[spec.index].input_features) + " and " +
+                               std::to_string(indexes[0].input_features) + " features)");
+    }
+    readers.push_back(openFeatureReader(shardOutputPath(path, spec)));
+  }
+
+  /* The shards are few, so the smallest next ordinal is found by a scan */
+  std::unique_ptr<FeatureWriter> output = openFeatureWriter(path);
+  std::vector<size_t> next(indexes.size(), 0);
+  std::string_view record;
+  for (;;)
+  {
+    size_t shard = indexes.size();
+    for (size_t s = 0; s < indexes.size(); ++s)
+    {
+      if (next[s] == indexes[s].ordinals.size())
+      {
+        continue;
+      }
+      if (shard < indexes.size() && indexes[s].ordinals[next[s]] == indexes[shard].ordinals[next[shard]])
+      {
+        throw std::runtime_error("Feature " + std::to_string(indexes[s].ordinals[next[s]]) +
+                                 " was written by more than one shard (shards run with different --shard keys?)");
+      }
+      if (shard == indexes.size() || indexes[s].ordinals[next[s]] < indexes[shard].ordinals[next[shard]])
+      {
+        shard = s;
+      }
+    }
+    if (shard == indexes.size())
+    {
+      break;
+    }
+    spec.index = shard;
+    if (!readers[shard]->next(record))
+    {
+      throw std::runtime_error(shardOutputPath(path, spec) + " has fewer features than its shard index");
+    }
+    output->write(record);
+    next[shard]++;
+  }
+  for (spec.index = 0; spec.index < spec.count; ++spec.index)
+  {
+    if (readers[spec.index]->next(record))
+    {
+      throw std::runtime_error(shardOutputPath(path, spec) + " has more features than its shard index");
+    }
+  }
+  output->close();
+  return output->count();
+}
@@ -0,0 +1,75 @@
+/*
+ * Splitting a run over independent processes (--shard) and merging their
+ * outputs back together (merge).
+ *
+ * Shard I of N processes the features assigned to it, by a hash of their
+ * ":id" or of the map tile their envelope's center falls in, and leaves
+ * the others out of its outputs. The assignment only depends on the record
+ * itself, so every machine computes the same partition without talking to
+ * the others. Each shard writes the output paths with a ".shard-I-of-N"
+ * suffix plus an index listing the input ordinals of the features it
+ * wrote; the merge interleaves the shard outputs by those ordinals, which
+ * gives the order of a single run byte for byte.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "feature_io.h"
+
+enum class ShardKey
+{
+  Id,  // FNV-1a of ":id" (the input ordinal if there is none)
+  Tile // The SHARD_TILE_DEGREES tile of the envelope center, for spatial locality
+};
+
+struct ShardSpec
+{
+  size_t index = 0; // 0-based; the command line counts from 1
+  size_t count = 1;
+  ShardKey key = ShardKey::Id;
+
+  bool enabled() const { return count > 1; }
+
+  /* "shard-I-of-N", as used in the output paths */
+  std::string label() const;
+
+  /* "I/N by :id" or "I/N by tile" for the console */
+  std::string describe() const;
+};
+
+/* Parse "I/N", "I/N:id" or "I/N:tile" with 1 <= I <= N */
+ShardSpec parseShardSpec(const std::string &text);
+
+/* Shard (0-based) a record with this summary and input ordinal belongs to */
+size_t shardOf(const ShardSpec &spec, const RecordSummary &summary, size_t ordinal);
+
+/* `path` with the shard label before its extension */
+std::string shardOutputPath(const std::string &path, const ShardSpec &spec);
+
+/* Index of the features a shard wrote, next to its concave hulls output */
+std::string shardIndexPath(const std::string &shard_hulls_path);
+
+/* One line "shard I/N of T features", then the input ordinal of every written feature */
+void writeShardIndex(const std::string &path, const ShardSpec &spec, size_t input_features,
+                     const std::vector<size_t> &ordinals);
+
+struct ShardIndex
+{
+  size_t input_features = 0;
+  std::vector<size_t> ordinals; // Increasing
+};
+
+/* Read and check the index of shard `spec` */
+ShardIndex readShardIndex(const std::string &path, const ShardSpec &spec);
+
+/*
+ * Merge the N shard files of `path` (shardOutputPath) into `path` in input
+ * order, as given by the shard indexes; returns the number of features.
+ * Throws if a shard file doesn't hold as many features as its index.
+ */
+size_t mergeShardOutputs(const std::string &path, const std::vector<ShardIndex> &indexes);
@@ -0,0 +1,140 @@
+#include "file_io.h"
+
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Buffered bytes before a write(2) */
+const size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+MappedFile::MappedFile(const std::string &path) : path_(path)
+{
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    throw std::runtime_error("Could not open file: " + path);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    close(fd);
+    throw std::runtime_error("Could not stat file: " + path);
+  }
+  size_ = static_cast<size_t>(st.st_size);
+
+  if (size_ > 0)
+  {
+    void *mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+      close(fd);
+      throw std::runtime_error("Could not map file: " + path);
+    }
+    madvise(mapping, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char *>(mapping);
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if (data_)
+  {
+    munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+OutputFile::OutputFile(const std::string &path) : path_(path)
+{
+  fd_ = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd_ < 0)
+  {
+    throw std::runtime_error("Could not write to file: " + path);
+  }
+  buffer_.reserve(WRITE_BUFFER_SIZE);
+}
+
+OutputFile::~OutputFile()
+{
+  if (fd_ >= 0)
+  {
+    /* Not closed explicitly (error path): keep what was written */
+    try
+    {
+      flush();
+    }
+    catch (const std::exception &)
+    {
+    }
+    ::close(fd_);
+  }
+}
+
+void OutputFile::append(std::string_view bytes)
+{
+  if (buffer_.size() + bytes.size() > WRITE_BUFFER_SIZE)
+  {
+    flush();
+  }
+  buffer_.append(bytes);
+}
+
+void OutputFile::patch(uint64_t offset, std::string_view bytes)
+{
+  flush();
+  const char *data = bytes.data();
+  size_t remaining = bytes.size();
+  while (remaining > 0)
+  {
+    ssize_t written = ::pwrite(fd_, data, remaining, static_cast<off_t>(offset));
+    if (written < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      throw std::runtime_error("Could not write to file: " + path_);
+    }
+    data += written;
+    offset += static_cast<uint64_t>(written);
+    remaining -= static_cast<size_t>(written);
+  }
+}
+
+void OutputFile::flush()
+{
+  const char *data = buffer_.data();
+  size_t remaining = buffer_.size();
+  while (remaining > 0)
+  {
+    ssize_t written = ::write(fd_, data, remaining);
+    if (written < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      throw std::runtime_error("Could not write to file: " + path_);
+    }
+    data += written;
+    remaining -= static_cast<size_t>(written);
+  }
+  flushed_ += buffer_.size();
+  buffer_.clear();
+}
+
+void OutputFile::close()
+{
+  flush();
+  int fd = fd_;
+  fd_ = -1;
+  if (::close(fd) != 0)
+  {
+    throw std::runtime_error("Could not write to file: " + path_);
+  }
+}
@@ -0,0 +1,61 @@
+/*
+ * Low-level file access shared by the feature readers and writers.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/* Read-only memory mapping of a whole file */
+class MappedFile
+{
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+  const std::string &path() const { return path_; }
+
+private:
+  std::string path_;
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/* Write-only file behind a large buffer, flushed with write(2) */
+class OutputFile
+{
+public:
+  explicit OutputFile(const std::string &path);
+  ~OutputFile();
+
+  OutputFile(const OutputFile &) = delete;
+  OutputFile &operator=(const OutputFile &) = delete;
+
+  void append(std::string_view bytes);
+
+  /* Overwrite bytes that were already appended (e.g. a header); flushes first */
+  void patch(uint64_t offset, std::string_view bytes);
+
+  /* Bytes appended so far */
+  uint64_t offset() const { return flushed_ + buffer_.size(); }
+
+  void close();
+
+  const std::string &path() const { return path_; }
+
+private:
+  void flush();
+
+  std::string path_;
+  int fd_ = -1;
+  std::string buffer_;
+  uint64_t flushed_ = 0;
+};
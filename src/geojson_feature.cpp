@@ -0,0 +1,257 @@
+#include "geojson_feature.h"
+
+#include <algorithm>
+
+#include <geos/io/GeoJSONWriter.h> /* Brings in the vendored nlohmann JSON */
+
+#include "geojson_stream.h"
+
+using namespace geos::io;
+
+/* Same ordered JSON type GeoJSONWriter encodes with */
+using ordered_json = geos_nlohmann::ordered_json;
+
+namespace
+{
+  ordered_json encodeValue(const GeoJSONValue &value)
+  {
+    if (value.isNumber())
+    {
+      return value.getNumber();
+    }
+    if (value.isString())
+    {
+      return value.getString();
+    }
+    if (value.isBoolean())
+    {
+      return value.getBoolean();
+    }
+    if (value.isArray())
+    {
+      ordered_json array = ordered_json::array();
+      for (const GeoJSONValue &item : value.getArray())
+      {
+        array.push_back(encodeValue(item));
+      }
+      return array;
+    }
+    if (value.isObject())
+    {
+      ordered_json object = ordered_json::object();
+      for (const auto &entry : value.getObject())
+      {
+        object[entry.first] = encodeValue(entry.second);
+      }
+      return object;
+    }
+    return nullptr;
+  }
+
+  GeoJSONValue decodeValue(const ordered_json &value)
+  {
+    if (value.is_number())
+    {
+      return GeoJSONValue(value.get<double>());
+    }
+    if (value.is_string())
+    {
+      return GeoJSONValue(value.get<std::string>());
+    }
+    if (value.is_boolean())
+    {
+      return GeoJSONValue(value.get<bool>());
+    }
+    if (value.is_array())
+    {
+      std::vector<GeoJSONValue> array;
+      array.reserve(value.size());
+      for (const ordered_json &item : value)
+      {
+        array.push_back(decodeValue(item));
+      }
+      return GeoJSONValue(array);
+    }
+    if (value.is_object())
+    {
+      std::map<std::string, GeoJSONValue> object;
+      for (auto it = value.begin(); it != value.end(); ++it)
+      {
+        object[it.key()] = decodeValue(it.value());
+      }
+      return GeoJSONValue(object);
+    }
+    return GeoJSONValue();
+  }
+
+  void appendRawMember(std::string &out, bool &first, std::string_view key_json, std::string_view value_json)
+  {
+    if (!first)
+    {
+      out += ',';
+    }
+    first = false;
+    out.append(key_json);
+    out += ':';
+    out.append(value_json);
+  }
+
+  void appendMember(std::string &out, bool &first, const std::string &key, std::string_view value_json)
+  {
+    appendRawMember(out, first, ordered_json(key).dump(), value_json);
+  }
+
+  std::vector<const RawProperty *> sortedByKey(const std::vector<RawProperty> &extra_properties)
+  {
+    std::vector<const RawProperty *> extras;
+    for (const RawProperty &extra : extra_properties)
+    {
+      extras.push_back(&extra);
+    }
+    std::sort(extras.begin(), extras.end(),
+              [](const RawProperty *a, const RawProperty *b)
+              { return a->key < b->key; });
+    return extras;
+  }
+
+  /* Everything up to the opening brace of "properties" */
+  void appendFeatureStart(std::string &out, std::string_view geometry_json, const std::string &id)
+  {
+    out += "{\"type\":\"Feature\",";
+    if (!id.empty())
+    {
+      out += "\"id\":";
+      out += ordered_json(id).dump();
+      out += ',';
+    }
+    out += "\"geometry\":";
+    out.append(geometry_json);
+    out += ",\"properties\":{";
+  }
+}
+
+std::string propertyValueJson(const GeoJSONValue &value)
+{
+  return encodeValue(value).dump();
+}
+
+GeoJSONValue propertyValueFromJson(std::string_view json)
+{
+  return decodeValue(ordered_json::parse(json));
+}
+
+std::string writeFeatureJson(std::string_view geometry_json,
+                             const std::map<std::string, GeoJSONValue> &properties,
+                             const std::vector<RawProperty> &extra_properties,
+                             const std::string &id)
+{
+  std::vector<const RawProperty *> extras = sortedByKey(extra_properties);
+
+  std::string out;
+  out.reserve(geometry_json.size() + 64 * properties.size() + 64);
+  appendFeatureStart(out, geometry_json, id);
+
+  /* Merge both sorted key sequences, like inserting the extras into the std::map */
+  bool first = true;
+  auto extra = extras.begin();
+  for (const auto &property : properties)
+  {
+    for (; extra != extras.end() && (*extra)->key < property.first; ++extra)
+    {
+      appendMember(out, first, (*extra)->key, (*extra)->json);
+    }
+    if (extra != extras.end() && (*extra)->key == property.first)
+    {
+      appendMember(out, first, (*extra)->key, (*extra)->json);
+      ++extra;
+      continue;
+    }
+    appendMember(out, first, property.first, propertyValueJson(property.second));
+  }
+  for (; extra != extras.end(); ++extra)
+  {
+    appendMember(out, first, (*extra)->key, (*extra)->json);
+  }
+
+  out += "}}";
+  return out;
+}
+
+std::string writeFeatureJson(std::string_view geometry_json,
+                             std::string_view raw_properties,
+                             const std::vector<RawProperty> &extra_properties,
+                             const std::string &id)
+{
+  std::vector<const RawProperty *> extras = sortedByKey(extra_properties);
+  std::vector<std::string> extra_keys;
+  for (const RawProperty *extra : extras)
+  {
+    extra_keys.push_back(ordered_json(extra->key).dump());
+  }
+  std::vector<bool> replaced(extras.size(), false);
+
+  std::string out;
+  out.reserve(geometry_json.size() + raw_properties.size() + 64);
+  appendFeatureStart(out, geometry_json, id);
+
+  bool first = true;
+  forEachJsonMember(raw_properties, [&](std::string_view key_json, std::string_view value_json)
+                    {
+                      auto match = std::find(extra_keys.begin(), extra_keys.end(), key_json);
+                      if (match == extra_keys.end())
+                      {
+                        appendRawMember(out, first, key_json, value_json);
+                        return;
+                      }
+                      size_t i = match - extra_keys.begin();
+                      appendRawMember(out, first, key_json, extras[i]->json);
+                      replaced[i] = true; });
+  for (size_t i = 0; i < extras.size(); ++i)
+  {
+    if (!replaced[i])
+    {
+      appendRawMember(out, first, extra_keys[i], extras[i]->json);
+    }
+  }
+
+  out += "}}";
+  return out;
+}
+
+std::string geometryPropertyJson(std::string_view geometry_json)
+{
+  const std::string_view type_prefix = "{\"type\":\"";
+  const std::string_view coordinates_key = "\",\"coordinates\":";
+
+  if (geometry_json.substr(0, type_prefix.size()) == type_prefix && geometry_json.back() == '}')
+  {
+    size_t type_end = geometry_json.find('"', type_prefix.size());
+    if (type_end != std::string_view::npos &&
+        geometry_json.substr(type_end, coordinates_key.size()) == coordinates_key)
+    {
+      std::string_view type = geometry_json.substr(type_prefix.size(), type_end - type_prefix.size());
+      size_t coordinates_start = type_end + coordinates_key.size();
+      std::string_view coordinates = geometry_json.substr(coordinates_start, geometry_json.size() - 1 - coordinates_start);
+
+      std::string out;
+      out.reserve(geometry_json.size());
+      out += "{\"coordinates\":";
+      out.append(coordinates);
+      out += ",\"type\":\"";
+      out.append(type);
+      out += "\"}";
+      return out;
+    }
+  }
+
+  /* Anything else (e.g. a GeometryCollection): let the JSON library sort the members */
+  return geos_nlohmann::json::parse(geometry_json).dump();
+}
+
+std::string singleFeatureCollectionJson(std::string_view feature_json)
+{
+  std::string out(FEATURE_COLLECTION_HEADER);
+  out.append(feature_json);
+  out += FEATURE_COLLECTION_FOOTER;
+  return out;
+}
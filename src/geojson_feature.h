@@ -0,0 +1,65 @@
+/*
+ * GeoJSON feature serialization without building GeoJSONFeature objects.
+ *
+ * GeoJSONFeature owns its geometry and properties, so putting the same
+ * geometry into both output files used to mean cloning it. These functions
+ * serialize from borrowed geometry/properties instead and produce the same
+ * bytes as GeoJSONWriter::write(const GeoJSONFeature &).
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <geos/geom/Geometry.h>
+#include <geos/io/GeoJSON.h>
+
+/* Property added on top of a feature's own properties, as serialized JSON */
+struct RawProperty
+{
+  std::string key;
+  std::string json;
+  const geos::geom::Geometry *geometry = nullptr; // Set for geometry-valued properties (binary outputs store its WKB)
+};
+
+/* JSON text of a single property value */
+std::string propertyValueJson(const geos::io::GeoJSONValue &value);
+
+/* The property value of JSON text, the reverse of propertyValueJson; throws on malformed JSON */
+geos::io::GeoJSONValue propertyValueFromJson(std::string_view json);
+
+/*
+ * Serialize a feature from its geometry JSON (GeoJSONWriter::write(geometry))
+ * and properties. `extra_properties` are merged in key order and replace
+ * properties with the same key.
+ */
+std::string writeFeatureJson(std::string_view geometry_json,
+                             const std::map<std::string, geos::io::GeoJSONValue> &properties,
+                             const std::vector<RawProperty> &extra_properties,
+                             const std::string &id);
+
+/*
+ * Same, with the feature's properties as the raw text of their JSON object
+ * (--raw-properties). The members are copied through as they are, in their
+ * order; an extra replaces the member with its key in place, and the others
+ * follow in key order.
+ */
+std::string writeFeatureJson(std::string_view geometry_json,
+                             std::string_view raw_properties,
+                             const std::vector<RawProperty> &extra_properties,
+                             const std::string &id);
+
+/*
+ * Geometry JSON from GeoJSONWriter as it reads once stored in a property.
+ * Properties are written with their members in key order, so
+ * {"type":..,"coordinates":..} becomes {"coordinates":..,"type":..}; the
+ * coordinate text is spliced over as-is instead of being parsed and
+ * re-encoded.
+ */
+std::string geometryPropertyJson(std::string_view geometry_json);
+
+/* A FeatureCollection holding one serialized feature */
+std::string singleFeatureCollectionJson(std::string_view feature_json);
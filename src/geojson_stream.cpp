@@ -0,0 +1,465 @@
+#include "geojson_stream.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <geos/io/GeoJSONReader.h> /* Brings in the vendored nlohmann JSON */
+
+namespace
+{
+  /*
+   * Cursor over JSON text that skips values without parsing them; the one
+   * implementation of the string and nesting rules, for GeoJSONFeatureStream
+   * and the member helpers alike
+   */
+  struct JsonScanner
+  {
+    std::string_view text;
+    size_t pos = 0;
+    const std::string *path = nullptr; // File the text was mapped from, for error messages
+
+    [[noreturn]] void fail(const std::string &message) const
+    {
+      if (path)
+      {
+        throw std::runtime_error("Malformed GeoJSON in " + *path + " at byte " + std::to_string(pos) + ": " + message);
+      }
+      throw std::runtime_error("Malformed JSON object at byte " + std::to_string(pos) + ": " + message);
+    }
+
+    bool at(char c) const { return pos < text.size() && text[pos] == c; }
+
+    void expect(char c, const char *message)
+    {
+      if (!at(c))
+      {
+        fail(message);
+      }
+      pos++;
+    }
+
+    void skipWhitespace()
+    {
+      while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' || text[pos] == '\t'))
+      {
+        pos++;
+      }
+    }
+
+    void skipString()
+    {
+      /* pos is on the opening quote */
+      for (pos++; pos < text.size(); pos++)
+      {
+        if (text[pos] == '\\')
+        {
+          pos++;
+        }
+        else if (text[pos] == '"')
+        {
+          pos++;
+          return;
+        }
+      }
+      fail("unterminated string");
+    }
+
+    void skipValue()
+    {
+      if (pos >= text.size())
+      {
+        fail("unexpected end of input");
+      }
+      if (at('"'))
+      {
+        skipString();
+        return;
+      }
+      if (!at('{') && !at('['))
+      {
+        /* Number, true, false or null */
+        while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && text[pos] != ']' && text[pos] != ' ' &&
+               text[pos] != '\n' && text[pos] != '\r' && text[pos] != '\t')
+        {
+          pos++;
+        }
+        return;
+      }
+
+      size_t depth = 0;
+      while (pos < text.size())
+      {
+        char c = text[pos];
+        if (c == '"')
+        {
+          skipString();
+          continue;
+        }
+        if (c == '{' || c == '[')
+        {
+          depth++;
+        }
+        else if ((c == '}' || c == ']') && --depth == 0)
+        {
+          pos++;
+          return;
+        }
+        pos++;
+      }
+      fail("unterminated object or array");
+    }
+  };
+}
+
+GeoJSONFeatureStream::GeoJSONFeatureStream(const std::string &path)
+    : file_(path), data_(file_.data()), size_(file_.size())
+{
+  seekFeatures();
+}
+
+void GeoJSONFeatureStream::fail(const std::string &message) const
+{
+  throw std::runtime_error("Malformed GeoJSON in " + file_.path() + " at byte " + std::to_string(pos_) + ": " + message);
+}
+
+void GeoJSONFeatureStream::skipWhitespace()
+{
+  JsonScanner scan{std::string_view(data_, size_), pos_, &file_.path()};
+  scan.skipWhitespace();
+  pos_ = scan.pos;
+}
+
+void GeoJSONFeatureStream::skipString()
+{
+  JsonScanner scan{std::string_view(data_, size_), pos_, &file_.path()};
+  scan.skipString();
+  pos_ = scan.pos;
+}
+
+void GeoJSONFeatureStream::skipValue()
+{
+  JsonScanner scan{std::string_view(data_, size_), pos_, &file_.path()};
+  scan.skipValue();
+  pos_ = scan.pos;
+}
+
+/* Walk the top-level object up to the opening bracket of its "features" array */
+void GeoJSONFeatureStream::seekFeatures()
+{
+  skipWhitespace();
+  if (pos_ >= size_ || data_[pos_] != '{')
+  {
+    fail("expected a FeatureCollection object");
+  }
+  pos_++;
+
+  for (;;)
+  {
+    skipWhitespace();
+    if (pos_ < size_ && data_[pos_] == '}')
+    {
+      finished_ = true; // No "features" member
+      return;
+    }
+    if (pos_ >= size_ || data_[pos_] != '"')
+    {
+      fail("expected a member name");
+    }
+
+    size_t key_start = pos_ + 1;
+    skipString();
+    std::string_view key(data_ + key_start, pos_ - key_start - 1);
+
+    skipWhitespace();
+    if (pos_ >= size_ || data_[pos_] != ':')
+    {
+      fail("expected ':'");
+    }
+    pos_++;
+    skipWhitespace();
+
+    if (key == "features")
+    {
+      if (pos_ >= size_ || data_[pos_] != '[')
+      {
+        fail("\"features\" is not an array");
+      }
+      pos_++;
+      return;
+    }
+
+    skipValue();
+    skipWhitespace();
+    if (pos_ < size_ && data_[pos_] == ',')
+    {
+      pos_++;
+    }
+  }
+}
+
+bool GeoJSONFeatureStream::next(std::string_view &feature_json)
+{
+  if (finished_)
+  {
+    return false;
+  }
+
+  skipWhitespace();
+  if (count_ > 0 && pos_ < size_ && data_[pos_] == ',')
+  {
+    pos_++;
+    skipWhitespace();
+  }
+  if (pos_ < size_ && data_[pos_] == ']')
+  {
+    finished_ = true;
+    return false;
+  }
+  if (pos_ >= size_ || data_[pos_] != '{')
+  {
+    fail("expected a feature object");
+  }
+
+  size_t start = pos_;
+  skipValue();
+  feature_json = std::string_view(data_ + start, pos_ - start);
+  count_++;
+  return true;
+}
+
+FeatureCollectionWriter::FeatureCollectionWriter(const std::string &path) : file_(path)
+{
+  file_.append(FEATURE_COLLECTION_HEADER);
+}
+
+void FeatureCollectionWriter::write(std::string_view feature_json)
+{
+  if (count_ > 0)
+  {
+    file_.append(",");
+  }
+  file_.append(feature_json);
+  count_++;
+}
+
+void FeatureCollectionWriter::close()
+{
+  file_.append(FEATURE_COLLECTION_FOOTER);
+  file_.close();
+}
+
+void forEachJsonMember(std::string_view object_json,
+                       const std::function<void(std::string_view, std::string_view)> &member)
+{
+  JsonScanner scan{object_json};
+  scan.skipWhitespace();
+  scan.expect('{', "expected an object");
+  scan.skipWhitespace();
+  if (scan.at('}'))
+  {
+    return;
+  }
+  for (;;)
+  {
+    scan.skipWhitespace();
+    if (!scan.at('"'))
+    {
+      scan.fail("expected a member name");
+    }
+    size_t key_start = scan.pos;
+    scan.skipString();
+    std::string_view key = object_json.substr(key_start, scan.pos - key_start);
+
+    scan.skipWhitespace();
+    scan.expect(':', "expected ':'");
+    scan.skipWhitespace();
+    size_t value_start = scan.pos;
+    scan.skipValue();
+    member(key, object_json.substr(value_start, scan.pos - value_start));
+
+    scan.skipWhitespace();
+    if (scan.at('}'))
+    {
+      return;
+    }
+    scan.expect(',', "expected ',' or '}'");
+  }
+}
+
+PropertySplit splitFeatureProperties(std::string_view feature_json, const std::vector<std::string> &keys)
+{
+  PropertySplit split;
+  forEachJsonMember(feature_json, [&](std::string_view key, std::string_view value)
+                    {
+                      if (key == "\"properties\"" && !value.empty() && value[0] == '{')
+                      {
+                        split.raw = value;
+                      } });
+  if (split.raw.empty())
+  {
+    split.reduced = std::string(feature_json);
+    return split;
+  }
+
+  /* Keys are compared as written, which is enough for the unescaped names the stages use */
+  std::string kept = "{";
+  forEachJsonMember(split.raw, [&](std::string_view key, std::string_view value)
+                    {
+                      std::string_view name = key.substr(1, key.size() - 2);
+                      if (std::find(keys.begin(), keys.end(), name) == keys.end())
+                      {
+                        return;
+                      }
+                      if (kept.size() > 1)
+                      {
+                        kept += ',';
+                      }
+                      kept.append(key);
+                      kept += ':';
+                      kept.append(value); });
+  kept += '}';
+
+  size_t start = split.raw.data() - feature_json.data();
+  split.reduced.reserve(feature_json.size() - split.raw.size() + kept.size());
+  split.reduced.append(feature_json.substr(0, start));
+  split.reduced.append(kept);
+  split.reduced.append(feature_json.substr(start + split.raw.size()));
+  return split;
+}
+
+namespace
+{
+  using sax_json = geos_nlohmann::json;
+
+  /*
+   * Tracks where the parser is in the feature object: the "coordinates"
+   * arrays below "geometry" feed the envelope (first two numbers of every
+   * innermost array are x and y), and string members of "properties" listed
+   * in `keys` are kept.
+   */
+  class SummaryHandler : public geos_nlohmann::json_sax<sax_json>
+  {
+  public:
+    SummaryHandler(const std::vector<std::string> &keys, RecordSummary &summary) : keys_(keys), summary_(summary) {}
+
+    bool null() override { return value(); }
+    bool boolean(bool) override { return value(); }
+    bool number_integer(number_integer_t v) override { return number(static_cast<double>(v)); }
+    bool number_unsigned(number_unsigned_t v) override { return number(static_cast<double>(v)); }
+    bool number_float(number_float_t v, const string_t &) override { return number(v); }
+    bool binary(binary_t &) override { return value(); }
+
+    bool string(string_t &v) override
+    {
+      if (!frames_.empty() && frames_.back().role == Role::Properties &&
+          std::find(keys_.begin(), keys_.end(), key_) != keys_.end())
+      {
+        summary_.strings[key_] = v;
+      }
+      return value();
+    }
+
+    bool start_object(std::size_t) override { return open(false); }
+    bool end_object() override { return close(); }
+    bool start_array(std::size_t) override { return open(true); }
+    bool end_array() override { return close(); }
+
+    bool key(string_t &k) override
+    {
+      key_ = k;
+      return true;
+    }
+
+    bool parse_error(std::size_t position, const std::string &, const geos_nlohmann::detail::exception &e) override
+    {
+      throw std::runtime_error("Malformed GeoJSON feature at byte " + std::to_string(position) + ": " + e.what());
+    }
+
+  private:
+    enum class Role
+    {
+      Other,
+      Geometry,    // Inside the feature's "geometry"
+      Coordinates, // Inside a "coordinates" array of the geometry
+      Properties   // The feature's "properties" object itself
+    };
+
+    struct Frame
+    {
+      bool array;
+      Role role;
+      size_t index; // Position of the next item, for arrays
+    };
+
+    bool open(bool array)
+    {
+      Role role = Role::Other;
+      if (frames_.size() == 1 && !frames_[0].array)
+      {
+        role = key_ == "geometry" ? Role::Geometry : key_ == "properties" ? Role::Properties : Role::Other;
+      }
+      else if (!frames_.empty())
+      {
+        Role parent = frames_.back().role;
+        if (parent == Role::Coordinates || (parent == Role::Geometry && array && key_ == "coordinates"))
+        {
+          role = Role::Coordinates;
+        }
+        else if (parent == Role::Geometry)
+        {
+          role = Role::Geometry; // e.g. members of a GeometryCollection
+        }
+      }
+      value();
+      frames_.push_back({array, role, 0});
+      return true;
+    }
+
+    bool close()
+    {
+      frames_.pop_back();
+      return true;
+    }
+
+    /* Count an item in the enclosing array */
+    bool value()
+    {
+      if (!frames_.empty() && frames_.back().array)
+      {
+        frames_.back().index++;
+      }
+      return true;
+    }
+
+    bool number(double v)
+    {
+      if (!frames_.empty() && frames_.back().role == Role::Coordinates && frames_.back().array)
+      {
+        size_t index = frames_.back().index;
+        if (index == 0)
+        {
+          x_ = v;
+        }
+        else if (index == 1)
+        {
+          summary_.envelope.expandToInclude(x_, v);
+        }
+      }
+      return value();
+    }
+
+    const std::vector<std::string> &keys_;
+    RecordSummary &summary_;
+    std::vector<Frame> frames_;
+    std::string key_;
+    double x_ = 0.0;
+  };
+}
+
+RecordSummary summarizeGeoJSONFeature(std::string_view feature_json, const std::vector<std::string> &keys)
+{
+  RecordSummary summary;
+  SummaryHandler handler(keys, summary);
+  sax_json::sax_parse(feature_json.begin(), feature_json.end(), &handler);
+  return summary;
+}
@@ -0,0 +1,98 @@
+/*
+ * Streaming access to the features of a GeoJSON FeatureCollection.
+ *
+ * The input file is memory-mapped and scanned lazily: each call to next()
+ * returns the raw text of one feature object without building a DOM for the
+ * rest of the document, so memory use doesn't grow with the size of the input.
+ * Output collections are written the same way, one serialized feature at a
+ * time.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "feature_io.h"
+#include "file_io.h"
+
+/* Framing of a FeatureCollection, as written by GeoJSONWriter */
+constexpr std::string_view FEATURE_COLLECTION_HEADER = "{\"type\":\"FeatureCollection\",\"features\":[";
+constexpr std::string_view FEATURE_COLLECTION_FOOTER = "]}";
+
+class GeoJSONFeatureStream : public FeatureReader
+{
+public:
+  explicit GeoJSONFeatureStream(const std::string &path);
+
+  /* Text of the next feature object; false once the "features" array is exhausted */
+  bool next(std::string_view &feature_json) override;
+
+  /* Number of features returned so far */
+  size_t count() const override { return count_; }
+
+private:
+  void seekFeatures();
+  void skipWhitespace();
+  void skipString();
+  void skipValue();
+  [[noreturn]] void fail(const std::string &message) const;
+
+  MappedFile file_;
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  size_t pos_ = 0;
+  size_t count_ = 0;
+  bool finished_ = false;
+};
+
+/*
+ * Envelope and selected string properties of one feature object, from a SAX
+ * pass over its text: coordinates are parsed but no geometry or property
+ * DOM is built.
+ */
+RecordSummary summarizeGeoJSONFeature(std::string_view feature_json, const std::vector<std::string> &keys);
+
+/*
+ * Calls `member(key_json, value_json)` for every member of the JSON object
+ * `object_json`, in order. Both are spans of the input text; the key keeps
+ * its quotes and escapes. Values are skipped over, not parsed.
+ */
+void forEachJsonMember(std::string_view object_json,
+                       const std::function<void(std::string_view, std::string_view)> &member);
+
+/* A feature object's "properties", split off for raw passthrough (--raw-properties) */
+struct PropertySplit
+{
+  std::string_view raw; // Text of the properties object; empty if it isn't an object
+  std::string reduced;  // The feature's text with only the requested properties left
+};
+
+/* Split the properties of `feature_json`, keeping the members named in `keys` */
+PropertySplit splitFeatureProperties(std::string_view feature_json, const std::vector<std::string> &keys);
+
+/*
+ * Writes a FeatureCollection incrementally through a buffered file
+ * descriptor. Features are appended as already-serialized JSON objects; the
+ * framing matches GeoJSONWriter's output for a whole collection.
+ */
+class FeatureCollectionWriter : public FeatureWriter
+{
+public:
+  explicit FeatureCollectionWriter(const std::string &path);
+
+  void write(std::string_view feature_json) override;
+
+  /* Terminate the collection and close the file */
+  void close() override;
+
+  /* Number of features written so far */
+  size_t count() const override { return count_; }
+
+private:
+  OutputFile file_;
+  size_t count_ = 0;
+};
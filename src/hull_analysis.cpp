@@ -0,0 +1,259 @@
+#include "hull_analysis.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include <geos/algorithm/MinimumAreaRectangle.h>
+#include <geos/algorithm/MinimumBoundingCircle.h>
+#include <geos/geom/CoordinateSequence.h>
+#include <geos/geom/LinearRing.h>
+#include <geos/geom/Polygon.h>
+#include <geos/io/GeoJSONWriter.h> /* Brings in the vendored nlohmann JSON */
+#include <geos/simplify/DouglasPeuckerSimplifier.h>
+
+#include "projection.h"
+
+using namespace geos::geom;
+using json = geos_nlohmann::json;
+
+/* Same search bounds as 2a_concave_hull_analysis.py */
+const int TRIANGLE_SEARCH_MAX_ITERATIONS = 200;
+const double TRIANGLE_SEARCH_MIN_INTERVAL = 0.00001;
+
+namespace
+{
+  struct Point2
+  {
+    double x;
+    double y;
+  };
+
+  /* Exterior ring of a Polygon in UTM, closing point included */
+  std::vector<Point2> exteriorPoints(const Geometry &polygon)
+  {
+    std::vector<Point2> points;
+    const CoordinateSequence *coords = static_cast<const Polygon &>(polygon).getExteriorRing()->getCoordinatesRO();
+    for (size_t i = 0; i < coords->size(); ++i)
+    {
+      points.push_back({coords->getX(i), coords->getY(i)});
+    }
+    return points;
+  }
+
+  /* [[lon, lat], ...] of UTM points */
+  json lonLatArray(const std::vector<Point2> &points)
+  {
+    std::vector<double> x, y;
+    for (const Point2 &p : points)
+    {
+      x.push_back(p.x);
+      y.push_back(p.y);
+    }
+    TransverseMercator::utm18n().inverse(x.data(), y.data(), x.size());
+    json out = json::array();
+    for (size_t i = 0; i < x.size(); ++i)
+    {
+      out.push_back({x[i], y[i]});
+    }
+    return out;
+  }
+
+  double distance(const Point2 &a, const Point2 &b)
+  {
+    return std::sqrt((b.x - a.x) * (b.x - a.x) + (b.y - a.y) * (b.y - a.y));
+  }
+
+  /* null for NaN/inf, like the script's None for undefined ratios */
+  json number(bool defined, double value)
+  {
+    return defined ? json(value) : json(nullptr);
+  }
+
+  json circleAnalysis(const Geometry &hull, double area, double perimeter)
+  {
+    json out;
+    out["ch_area_sqm"] = area;
+    out["ch_perimeter_m"] = perimeter;
+    out["polsby_popper"] = number(perimeter > 0, 4 * M_PI * area / (perimeter * perimeter));
+    out["schwartzberg"] = number(area > 0, perimeter / (2 * M_PI * std::sqrt(area / M_PI)));
+
+    /* The polygonal circle GEOS (and shapely) return, so the areas match the script's */
+    geos::algorithm::MinimumBoundingCircle bounding_circle(&hull);
+    double circle_area = bounding_circle.getCircle()->getArea();
+    bool has_circle = circle_area > 0;
+    out["reock_compactness"] = number(has_circle, area / circle_area);
+    out["circumscribed_circle_radius"] = number(has_circle, std::sqrt(circle_area / M_PI));
+    out["circumscribed_circle_area"] = number(has_circle, circle_area);
+    return out;
+  }
+
+  json rectangularityAnalysis(const Geometry &hull, double area, double original_area_sqm)
+  {
+    json out;
+    std::unique_ptr<Geometry> rectangle = geos::algorithm::MinimumAreaRectangle::getMinimumRectangle(&hull);
+    std::vector<Point2> corners;
+    if (rectangle && rectangle->getGeometryTypeId() == GEOS_POLYGON)
+    {
+      corners = exteriorPoints(*rectangle);
+    }
+    out["mrr_vertices"] = lonLatArray(corners);
+
+    if (corners.size() >= 5)
+    {
+      /* Width is the longer of the first two edges; the angle is that edge's, in [0, 180) */
+      double edge1 = distance(corners[0], corners[1]);
+      double edge2 = distance(corners[1], corners[2]);
+      out["mrr_width"] = std::max(edge1, edge2);
+      out["mrr_height"] = std::min(edge1, edge2);
+      const Point2 &from = edge1 > edge2 ? corners[0] : corners[1];
+      const Point2 &to = edge1 > edge2 ? corners[1] : corners[2];
+      double rotation = std::atan2(to.y - from.y, to.x - from.x) * 180.0 / M_PI;
+      if (rotation < 0)
+      {
+        rotation += 180;
+      }
+      else if (rotation >= 180)
+      {
+        rotation -= 180;
+      }
+      out["mrr_rotation_degrees"] = rotation;
+    }
+    else
+    {
+      out["mrr_width"] = nullptr;
+      out["mrr_height"] = nullptr;
+      out["mrr_rotation_degrees"] = nullptr;
+    }
+
+    double rectangle_area = rectangle ? rectangle->getArea() : 0.0;
+    out["mrr_area_sqm"] = rectangle_area;
+    out["mrr_rectangularity"] = number(rectangle_area > 0, area / rectangle_area);
+    out["mrr_original_ratio"] = number(!std::isnan(original_area_sqm) && rectangle_area > 0,
+                                       original_area_sqm / rectangle_area);
+    return out;
+  }
+
+  json emptyTriangularity()
+  {
+    json out;
+    for (const char *key : {"triangle_vertices", "triangle_area_sqm", "triangle_perimeter_m", "triangularity",
+                            "dp_tolerance", "triangle_edge_lengths", "triangle_num_vertices", "triangle_regularity"})
+    {
+      out[key] = nullptr;
+    }
+    return out;
+  }
+
+  json triangularityAnalysis(const Geometry &hull, double area)
+  {
+    /* Bisect the Douglas-Peucker tolerance towards a 3-vertex polygon, step for step like the script */
+    double min_tolerance = 0.0;
+    double max_tolerance = hull.getLength() * 2;
+    double tolerance = 1.0;
+    std::unique_ptr<Geometry> simplified;
+    std::unique_ptr<Geometry> best_simplified;
+    double best_vertex_count = std::numeric_limits<double>::infinity();
+
+    for (int iteration = 0; iteration < TRIANGLE_SEARCH_MAX_ITERATIONS; ++iteration)
+    {
+      std::unique_ptr<Geometry> test = geos::simplify::DouglasPeuckerSimplifier::simplify(&hull, tolerance);
+      if (!test || test->getGeometryTypeId() != GEOS_POLYGON)
+      {
+        /* Simplified into something else: tolerance too high */
+        max_tolerance = tolerance;
+        tolerance = (min_tolerance + max_tolerance) / 2;
+        continue;
+      }
+
+      double vertices = static_cast<double>(static_cast<const Polygon &>(*test).getExteriorRing()->getNumPoints()) - 1;
+      if (vertices == 3)
+      {
+        simplified = std::move(test);
+        break;
+      }
+      if (std::abs(vertices - 3) < std::abs(best_vertex_count - 3))
+      {
+        best_simplified = std::move(test);
+        best_vertex_count = vertices;
+      }
+      if (vertices > 3)
+      {
+        min_tolerance = tolerance;
+      }
+      else
+      {
+        max_tolerance = tolerance;
+      }
+      tolerance = (min_tolerance + max_tolerance) / 2;
+
+      if (max_tolerance - min_tolerance < TRIANGLE_SEARCH_MIN_INTERVAL)
+      {
+        break;
+      }
+    }
+    if (!simplified)
+    {
+      simplified = std::move(best_simplified);
+    }
+    if (!simplified)
+    {
+      return emptyTriangularity();
+    }
+
+    json out;
+    out["dp_tolerance"] = tolerance;
+
+    std::vector<Point2> corners = exteriorPoints(*simplified);
+    if (!corners.empty())
+    {
+      corners.pop_back(); // Closing point
+    }
+    out["triangle_vertices"] = lonLatArray(corners);
+
+    double triangle_area = simplified->getArea();
+    out["triangle_area_sqm"] = triangle_area;
+    out["triangle_perimeter_m"] = simplified->getLength();
+    out["triangularity"] = number(triangle_area > 0, area / triangle_area);
+
+    if (corners.size() >= 3)
+    {
+      json edge_lengths = json::array();
+      double shortest = std::numeric_limits<double>::infinity();
+      double longest = 0.0;
+      for (size_t i = 0; i < corners.size(); ++i)
+      {
+        double length = distance(corners[i], corners[(i + 1) % corners.size()]);
+        edge_lengths.push_back(length);
+        shortest = std::min(shortest, length);
+        longest = std::max(longest, length);
+      }
+      out["triangle_edge_lengths"] = std::move(edge_lengths);
+      out["triangle_num_vertices"] = corners.size();
+      out["triangle_regularity"] = number(longest > 0, shortest / longest);
+    }
+    else
+    {
+      out["triangle_edge_lengths"] = nullptr;
+      out["triangle_num_vertices"] = corners.empty() ? json(nullptr) : json(corners.size());
+      out["triangle_regularity"] = nullptr;
+    }
+    return out;
+  }
+}
+
+std::vector<RawProperty> computeHullAnalysis(const Geometry &hull_utm, double original_area_sqm)
+{
+  double area = hull_utm.getArea();
+  double perimeter = hull_utm.getLength();
+  return {
+      {"circle_analysis", circleAnalysis(hull_utm, area, perimeter).dump()},
+      {"rectangularity_analysis", rectangularityAnalysis(hull_utm, area, original_area_sqm).dump()},
+      {"triangularity_analysis", triangularityAnalysis(hull_utm, area).dump()}};
+}
+
+std::vector<RawProperty> emptyHullAnalysis()
+{
+  return {{"circle_analysis", "null"}, {"rectangularity_analysis", "null"}, {"triangularity_analysis", "null"}};
+}
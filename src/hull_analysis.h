@@ -0,0 +1,28 @@
+/*
+ * The 2a_concave_hull_analysis.py shape metrics, computed in process for
+ * --output-analysis right after each hull is produced.
+ *
+ * Three object-valued properties, measured on the hull in UTM 18N like
+ * the Python stage: `circle_analysis` (Polsby-Popper, Schwartzberg, Reock
+ * against GEOS's minimum bounding circle), `rectangularity_analysis`
+ * (minimum rotated rectangle) and `triangularity_analysis` (the
+ * Douglas-Peucker tolerance search for a triangle, with the same bisection
+ * as the script). Vertices are stored back in longitude/latitude.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include <geos/geom/Geometry.h>
+
+#include "geojson_feature.h"
+
+/*
+ * Analysis of `hull_utm`, a concave hull in UTM 18N; `original_area_sqm`
+ * is the feature's area_sqm (NaN if it has none).
+ */
+std::vector<RawProperty> computeHullAnalysis(const geos::geom::Geometry &hull_utm, double original_area_sqm);
+
+/* The same properties as nulls, for features without a concave hull */
+std::vector<RawProperty> emptyHullAnalysis();
@@ -0,0 +1,217 @@
+#include "hull_cache.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+#include <geos/version.h>
+#include <geos/io/WKBConstants.h>
+#include <geos/io/WKBReader.h>
+#include <geos/io/WKBWriter.h>
+
+using namespace geos::geom;
+using namespace geos::io;
+
+/* Bump when the entry layout or the meaning of a step changes */
+const char CACHE_ENTRY_MAGIC[8] = {'N', 'Y', 'C', 'H', 'U', 'L', 'L', '1'};
+
+namespace
+{
+  /* 128-bit FNV-1a */
+  class ContentHash
+  {
+  public:
+    void update(const void *data, size_t size)
+    {
+      const unsigned char *bytes = static_cast<const unsigned char *>(data);
+      for (size_t i = 0; i < size; ++i)
+      {
+        state_ ^= bytes[i];
+        state_ *= PRIME;
+      }
+    }
+
+    void update(const std::string &text)
+    {
+      update(text.data(), text.size());
+      update("\0", 1);
+    }
+
+    template <typename T>
+    void updateValue(T value)
+    {
+      update(&value, sizeof(value));
+    }
+
+    std::string hex() const
+    {
+      static const char digits[] = "0123456789abcdef";
+      std::string out(32, '0');
+      unsigned __int128 v = state_;
+      for (int i = 31; i >= 0; --i)
+      {
+        out[i] = digits[static_cast<unsigned>(v & 0xf)];
+        v >>= 4;
+      }
+      return out;
+    }
+
+  private:
+    static constexpr unsigned __int128 PRIME = (static_cast<unsigned __int128>(1) << 88) + 0x13b;
+    unsigned __int128 state_ = (static_cast<unsigned __int128>(0x6c62272e07bb0142ULL) << 64) | 0x62b821756295c58dULL;
+  };
+}
+
+namespace
+{
+  /* Little-endian WKB, so hashes don't depend on the host */
+  std::string wkbOf(const Geometry &geometry)
+  {
+    std::ostringstream wkb;
+    WKBWriter writer;
+    writer.setByteOrder(WKBConstants::wkbNDR);
+    writer.write(geometry, wkb);
+    return wkb.str();
+  }
+}
+
+std::string geometryDigest(const Geometry &geometry)
+{
+  ContentHash hash;
+  hash.update(wkbOf(geometry));
+  return hash.hex();
+}
+
+HullCache::HullCache(const std::string &directory) : directory_(directory)
+{
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error)
+  {
+    throw std::runtime_error("Could not create hull cache directory: " + directory_);
+  }
+}
+
+std::string HullCache::key(const Geometry *polygons, const HullParameters &params, SearchStrategy strategy,
+                           const std::string &variant)
+{
+  ContentHash hash;
+  hash.update(std::string(CACHE_ENTRY_MAGIC, sizeof(CACHE_ENTRY_MAGIC)));
+  hash.update(GEOS_VERSION);
+
+  hash.updateValue(params.initial_threshold);
+  hash.updateValue(params.increment);
+  hash.updateValue(static_cast<int32_t>(params.max_attempts));
+  hash.updateValue(static_cast<uint8_t>(params.is_tight));
+  hash.updateValue(static_cast<uint8_t>(params.is_holes_allowed));
+  hash.updateValue(static_cast<uint8_t>(strategy));
+  hash.update(variant);
+
+  hash.update(wkbOf(*polygons));
+
+  return hash.hex();
+}
+
+std::string HullCache::settingsKey(const HullParameters &params, SearchStrategy strategy, const std::string &variant)
+{
+  ContentHash hash;
+  hash.update("settings");
+  hash.updateValue(params.initial_threshold);
+  hash.updateValue(params.increment);
+  hash.updateValue(static_cast<int32_t>(params.max_attempts));
+  hash.updateValue(static_cast<uint8_t>(params.is_tight));
+  hash.updateValue(static_cast<uint8_t>(params.is_holes_allowed));
+  hash.updateValue(static_cast<uint8_t>(strategy));
+  hash.update(variant);
+  return hash.hex();
+}
+
+std::string HullCache::entryPath(const std::string &key) const
+{
+  /* Two-level fan-out keeps directories small */
+  return directory_ + "/" + key.substr(0, 2) + "/" + key + ".hull";
+}
+
+bool HullCache::load(const std::string &key, const GeometryFactory &factory, CachedHull &entry) const
+{
+  std::ifstream file(entryPath(key), std::ios::binary);
+  if (!file.is_open())
+  {
+    return false;
+  }
+
+  char magic[sizeof(CACHE_ENTRY_MAGIC)];
+  int32_t step = 0;
+  int32_t attempts = 0;
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(&step), sizeof(step));
+  file.read(reinterpret_cast<char *>(&attempts), sizeof(attempts));
+  if (!file || !std::equal(magic, magic + sizeof(magic), CACHE_ENTRY_MAGIC))
+  {
+    return false;
+  }
+
+  try
+  {
+    WKBReader reader(factory);
+    entry.hull = reader.read(file);
+  }
+  catch (const std::exception &)
+  {
+    return false; // Truncated or corrupt entry: recompute it
+  }
+  entry.step = step;
+  entry.attempts = attempts;
+  return entry.hull != nullptr;
+}
+
+void HullCache::store(const std::string &key, const HullSearchResult &result) const
+{
+  if (!result.hull)
+  {
+    return;
+  }
+
+  std::string path = entryPath(key);
+  std::error_code error;
+  std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+  /* Write to a private file and rename it into place so readers never see a partial entry */
+  std::ostringstream suffix;
+  suffix << ".tmp." << getpid() << "." << std::this_thread::get_id();
+  std::string temp_path = path + suffix.str();
+  {
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+      return; // Caching is best-effort
+    }
+    int32_t step = result.step;
+    int32_t attempts = result.attempts;
+    file.write(CACHE_ENTRY_MAGIC, sizeof(CACHE_ENTRY_MAGIC));
+    file.write(reinterpret_cast<const char *>(&step), sizeof(step));
+    file.write(reinterpret_cast<const char *>(&attempts), sizeof(attempts));
+
+    WKBWriter writer;
+    writer.setByteOrder(WKBConstants::wkbNDR);
+    writer.write(*result.hull, file);
+    if (!file)
+    {
+      file.close();
+      std::remove(temp_path.c_str());
+      return;
+    }
+  }
+  std::filesystem::rename(temp_path, path, error);
+  if (error)
+  {
+    std::remove(temp_path.c_str());
+  }
+}
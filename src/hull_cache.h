@@ -0,0 +1,60 @@
+/*
+ * On-disk cache of concave hull search results.
+ *
+ * Entries are keyed by a hash of the input geometry's WKB together with
+ * everything that influences the search (hull parameters, search strategy,
+ * input simplification and GEOS version), so unchanged parks in a new Parks_Properties release
+ * hit the cache and changed ones miss it. Each entry stores the final
+ * threshold step and the hull as WKB, which round-trips coordinates exactly.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <geos/geom/Geometry.h>
+#include <geos/geom/GeometryFactory.h>
+
+#include "hull_engine.h"
+
+/* Hex content hash of a geometry's WKB, the identity hull reuse is based on */
+std::string geometryDigest(const geos::geom::Geometry &geometry);
+
+struct CachedHull
+{
+  std::unique_ptr<geos::geom::Geometry> hull;
+  int step = 0;     // Threshold step that produced the hull
+  int attempts = 0; // Hull computations the original search needed
+};
+
+class HullCache
+{
+public:
+  /* Cache rooted at `directory`, which is created if needed */
+  explicit HullCache(const std::string &directory);
+
+  /*
+   * Hex content hash identifying a hull search. `variant` names any other
+   * setting that changes the hull (e.g. pre-simplification).
+   */
+  static std::string key(const geos::geom::Geometry *polygons, const HullParameters &params, SearchStrategy strategy,
+                         const std::string &variant);
+
+  /*
+   * Hex hash of the settings key() covers, without the geometry. Written
+   * with every hull, so --previous only reuses hulls made the same way.
+   */
+  static std::string settingsKey(const HullParameters &params, SearchStrategy strategy, const std::string &variant);
+
+  /* Stored entry for `key`, with the hull created by `factory`; false on a miss */
+  bool load(const std::string &key, const geos::geom::GeometryFactory &factory, CachedHull &entry) const;
+
+  /* Store a search result; safe to call from several workers at once */
+  void store(const std::string &key, const HullSearchResult &result) const;
+
+private:
+  std::string entryPath(const std::string &key) const;
+
+  std::string directory_;
+};
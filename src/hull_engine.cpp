@@ -0,0 +1,537 @@
+#include "hull_engine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <numeric>
+
+#include <geos/geom/Envelope.h>
+#include <geos/algorithm/hull/ConcaveHullOfPolygons.h>
+#include <geos/util/Interrupt.h>
+
+#include "hull_triangulation.h"
+
+using namespace geos::geom;
+using namespace geos::algorithm::hull;
+
+/* Guards the lower bound against rounding between GEOS distances and triangle edge lengths */
+const double MIN_SINGLE_THRESHOLD_SLACK = 1e-9;
+
+float HullParameters::thresholdForStep(int step) const
+{
+  float threshold = initial_threshold;
+  for (int i = 0; i < step; ++i)
+  {
+    threshold += increment;
+  }
+  return threshold;
+}
+
+bool isSinglePolygon(const Geometry *hull)
+{
+  if (hull && hull->getGeometryTypeId() == GEOS_MULTIPOLYGON)
+  {
+    return hull->getNumGeometries() == 1;
+  }
+  return hull && hull->getGeometryTypeId() == GEOS_POLYGON;
+}
+
+namespace
+{
+  struct PartEdge
+  {
+    double distance;
+    size_t a;
+    size_t b;
+  };
+
+  size_t findRoot(std::vector<size_t> &parent, size_t i)
+  {
+    while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+
+  /* Deadline of the search running on this thread, read by the interrupt callback */
+  thread_local bool thread_has_deadline = false;
+  thread_local std::chrono::steady_clock::time_point thread_deadline;
+  geos::util::Interrupt::Callback *previous_interrupt_callback = nullptr;
+
+  void interruptPastDeadline()
+  {
+    if (previous_interrupt_callback)
+    {
+      previous_interrupt_callback();
+    }
+    if (thread_has_deadline && std::chrono::steady_clock::now() >= thread_deadline)
+    {
+      geos::util::Interrupt::interrupt(); // Throws on this thread only
+    }
+  }
+
+  /* Arms this thread's deadline while a hull is computed */
+  class DeadlineScope
+  {
+  public:
+    DeadlineScope(bool armed, std::chrono::steady_clock::time_point deadline)
+    {
+      thread_has_deadline = armed;
+      thread_deadline = deadline;
+    }
+    ~DeadlineScope() { thread_has_deadline = false; }
+  };
+
+  /* See HullEngine: smallest part distance at which one group of parts spans the full envelope */
+  double spanningPartDistance(const Geometry *polygons)
+  {
+    size_t n = polygons->getNumGeometries();
+    if (n < 2)
+    {
+      return 0.0;
+    }
+
+    const Envelope &total = *polygons->getEnvelopeInternal();
+    std::vector<const Envelope *> envelopes(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      envelopes[i] = polygons->getGeometryN(i)->getEnvelopeInternal();
+      if (envelopes[i]->contains(total))
+      {
+        return 0.0;
+      }
+    }
+
+    /* Prim's minimum spanning tree over part distances, pruned by envelope distance */
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> best(n, inf);
+    std::vector<size_t> nearest(n, 0);
+    std::vector<bool> in_tree(n, false);
+    std::vector<PartEdge> tree_edges;
+    best[0] = 0.0;
+
+    for (size_t iteration = 0; iteration < n; ++iteration)
+    {
+      size_t u = n;
+      for (size_t v = 0; v < n; ++v)
+      {
+        if (!in_tree[v] && (u == n || best[v] < best[u]))
+        {
+          u = v;
+        }
+      }
+      in_tree[u] = true;
+      if (iteration > 0)
+      {
+        tree_edges.push_back({best[u], nearest[u], u});
+      }
+
+      const Geometry *part_u = polygons->getGeometryN(u);
+      for (size_t v = 0; v < n; ++v)
+      {
+        if (in_tree[v] || envelopes[u]->distance(*envelopes[v]) >= best[v])
+        {
+          continue;
+        }
+        double d = part_u->distance(polygons->getGeometryN(v));
+        if (d < best[v])
+        {
+          best[v] = d;
+          nearest[v] = u;
+        }
+      }
+    }
+
+    /* Kruskal merge order: stop at the first group whose envelope covers every part */
+    std::sort(tree_edges.begin(), tree_edges.end(),
+              [](const PartEdge &x, const PartEdge &y)
+              { return x.distance < y.distance; });
+
+    std::vector<size_t> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    std::vector<Envelope> group_envelopes;
+    for (size_t i = 0; i < n; ++i)
+    {
+      group_envelopes.push_back(*envelopes[i]);
+    }
+
+    for (const PartEdge &edge : tree_edges)
+    {
+      size_t root_a = findRoot(parent, edge.a);
+      size_t root_b = findRoot(parent, edge.b);
+      parent[root_b] = root_a;
+      group_envelopes[root_a].expandToInclude(&group_envelopes[root_b]);
+      if (group_envelopes[root_a].contains(total))
+      {
+        return edge.distance;
+      }
+    }
+    return tree_edges.empty() ? 0.0 : tree_edges.back().distance;
+  }
+}
+
+double computeMinSingleThreshold(const Geometry *polygons)
+{
+  return spanningPartDistance(polygons);
+}
+
+void installHullInterruptCallback()
+{
+  static std::once_flag installed;
+  std::call_once(installed, []()
+                 { previous_interrupt_callback = geos::util::Interrupt::registerCallback(&interruptPastDeadline); });
+}
+
+HullEngine::HullEngine(const Geometry *polygons, const HullParameters &params)
+    : HullEngine(polygons, params, computeMinSingleThreshold(polygons))
+{
+}
+
+HullEngine::HullEngine(const Geometry *polygons, const HullParameters &params, double min_single_threshold)
+    : polygons_(polygons), params_(params), min_single_threshold_(min_single_threshold)
+{
+  double viable = min_single_threshold_ * (1.0 - MIN_SINGLE_THRESHOLD_SLACK);
+  while (first_viable_step_ < params_.max_attempts &&
+         static_cast<double>(params_.thresholdForStep(first_viable_step_)) < viable)
+  {
+    first_viable_step_++;
+  }
+}
+
+void HullEngine::setDeadline(std::chrono::steady_clock::time_point deadline)
+{
+  has_deadline_ = true;
+  deadline_ = deadline;
+}
+
+bool HullEngine::pastDeadline() const
+{
+  return has_deadline_ && std::chrono::steady_clock::now() >= deadline_;
+}
+
+void HullEngine::stopAtDeadline(HullSearchResult &result, std::ostream &log) const
+{
+  result.timed_out = true;
+  if (!result.hull)
+  {
+    result.hull = polygons_->convexHull();
+    result.convex_fallback = true;
+  }
+  log << "Time budget exceeded after " << result.attempts << " attempt(s), using "
+      << (result.convex_fallback ? "the convex hull" : "the best hull found") << "\n";
+}
+
+std::unique_ptr<Geometry> HullEngine::hullAt(int step, std::ostream &log) const
+{
+  float threshold = params_.thresholdForStep(step);
+  DeadlineScope deadline(has_deadline_, deadline_);
+  try
+  {
+    log << "Current threshold: " << threshold * params_.meters_per_unit << " meters" << "\n";
+    return ConcaveHullOfPolygons::concaveHullByLength(
+        polygons_,
+        threshold,
+        params_.is_tight,
+        params_.is_holes_allowed);
+  }
+  catch (const std::exception &e)
+  {
+    if (pastDeadline())
+    {
+      log << "Cancelled at the time budget" << "\n";
+      return nullptr;
+    }
+    log << "Error: " << e.what() << "\n";
+    log << "Concave Hull Failed, increasing threshold" << "\n";
+    return nullptr;
+  }
+}
+
+int HullEngine::erodedSingleStep(int start, HullSearchResult &result, std::ostream &log) const
+{
+  auto begin = std::chrono::steady_clock::now();
+  int found = -1;
+  try
+  {
+    DeadlineScope deadline(has_deadline_, deadline_);
+    HullTriangulation triangulation(polygons_);
+    found = params_.max_attempts;
+    for (int step = start; step < params_.max_attempts && !pastDeadline(); ++step)
+    {
+      if (triangulation.componentsAt(params_.thresholdForStep(step), params_.is_tight, params_.is_holes_allowed) == 1)
+      {
+        found = step;
+        break;
+      }
+    }
+    if (pastDeadline())
+    {
+      found = -1;
+    }
+    else if (found < params_.max_attempts)
+    {
+      log << "Triangulation (" << triangulation.triangles() << " triangles): one polygon from "
+          << params_.thresholdForStep(found) * params_.meters_per_unit << " meters" << "\n";
+    }
+    else
+    {
+      log << "Triangulation (" << triangulation.triangles() << " triangles): no threshold step gives one polygon" << "\n";
+    }
+  }
+  catch (const std::exception &e)
+  {
+    if (!pastDeadline())
+    {
+      log << "Triangulation failed (" << e.what() << "), searching step by step" << "\n";
+    }
+  }
+  result.triangulation_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  return found;
+}
+
+std::unique_ptr<Geometry> HullEngine::attempt(int step, std::ostream &log, HullSearchResult &result) const
+{
+  auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<Geometry> hull = hullAt(step, log);
+  result.hull_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  result.attempts++;
+  if (!hull && !pastDeadline())
+  {
+    result.failed_attempts++;
+  }
+  return hull;
+}
+
+/*
+ * The eroded triangulation names a step and GEOS checks it: a single
+ * polygon there and several one step below (or several at the last step,
+ * if no step erodes to one) is what the linear search would have ended on.
+ * When GEOS doesn't match, or the triangulation failed, the strategies
+ * below search the viable steps with GEOS alone, so the triangulation never
+ * moves the step the search picks.
+ *
+ * Both strategies pick the same step as long as going up a step never splits
+ * a hull back apart; bisect needs O(log n) hull computations instead of n.
+ * A step whose hull fails says nothing about its neighbours (GEOS
+ * robustness failures don't follow the threshold), so a failed probe never
+ * moves the bracket: probes that fail while doubling leave `lo` where it
+ * was, and a failed bisection midpoint makes the search scan the rest of
+ * the bracket step by step, as the linear search would. Steps below
+ * firstViableStep() are never computed.
+ */
+HullSearchResult HullEngine::search(SearchStrategy strategy, std::ostream &log) const
+{
+  HullSearchResult result;
+  int last_step = params_.max_attempts - 1;
+  int start = std::min(first_viable_step_, last_step);
+  result.skipped_steps = start;
+  if (start > 0)
+  {
+    log << "Skipping " << start << " threshold step(s) below "
+        << min_single_threshold_ * params_.meters_per_unit << " meters (parts too far apart)" << "\n";
+  }
+
+  int eroded = triangulated_ ? erodedSingleStep(start, result, log) : -1;
+  if (pastDeadline())
+  {
+    stopAtDeadline(result, log);
+    return result;
+  }
+  if (eroded >= 0)
+  {
+    result.eroded_step = eroded <= last_step ? eroded : -1;
+    int step = std::min(eroded, last_step);
+    std::unique_ptr<Geometry> hull = attempt(step, log, result);
+    bool matches = hull && isSinglePolygon(hull.get()) == (eroded <= last_step);
+    if (matches && eroded <= last_step && step - 1 >= start && !pastDeadline())
+    {
+      /* A triangulation that erodes less than GEOS names too late a step; the step below must not be single yet */
+      std::unique_ptr<Geometry> below = attempt(step - 1, log, result);
+      matches = !isSinglePolygon(below.get());
+    }
+    if (matches && !pastDeadline())
+    {
+      result.hull = std::move(hull);
+      result.step = step;
+      result.skipped_steps = eroded <= last_step ? std::max(step - 1, start) : step;
+      return result;
+    }
+    if (pastDeadline())
+    {
+      if (hull)
+      {
+        result.hull = std::move(hull);
+        result.step = step;
+      }
+      stopAtDeadline(result, log);
+      return result;
+    }
+    log << "The hulls around step " << step << " don't match the triangulation, searching step by step" << "\n";
+  }
+
+  if (strategy == SearchStrategy::Linear)
+  {
+    for (int step = start; step <= last_step; step++)
+    {
+      std::unique_ptr<Geometry> hull = attempt(step, log, result);
+      bool single = isSinglePolygon(hull.get());
+      if (hull)
+      {
+        result.hull = std::move(hull);
+        result.step = step;
+      }
+      if (single)
+      {
+        break;
+      }
+      if (pastDeadline())
+      {
+        stopAtDeadline(result, log);
+        return result;
+      }
+    }
+    return result;
+  }
+
+  /* Exponential phase: lo is a step below the answer, hi the first passing probe */
+  std::unique_ptr<Geometry> first = attempt(start, log, result);
+  if (isSinglePolygon(first.get()))
+  {
+    result.hull = std::move(first);
+    result.step = start;
+    return result;
+  }
+  if (first)
+  {
+    result.hull = std::move(first);
+    result.step = start;
+  }
+  if (pastDeadline())
+  {
+    stopAtDeadline(result, log);
+    return result;
+  }
+
+  std::vector<int> failed_steps; // Computed, no hull; skipped when the bracket is scanned
+  int lo = start;
+  int hi = -1;
+  std::unique_ptr<Geometry> hi_hull;
+  for (int offset = 1, probe = start; probe < last_step; offset *= 2)
+  {
+    probe = std::min(start + offset, last_step);
+    std::unique_ptr<Geometry> hull = attempt(probe, log, result);
+    if (isSinglePolygon(hull.get()))
+    {
+      hi = probe;
+      hi_hull = std::move(hull);
+      break;
+    }
+    if (hull)
+    {
+      lo = probe;
+      result.hull = std::move(hull);
+      result.step = probe;
+    }
+    else
+    {
+      failed_steps.push_back(probe);
+    }
+    if (pastDeadline())
+    {
+      stopAtDeadline(result, log);
+      return result;
+    }
+  }
+
+  /* First single-polygon step in (from, to), tried in turn; false at the deadline */
+  auto scan = [&](int from, int to)
+  {
+    for (int step = from + 1; step < to; ++step)
+    {
+      if (std::find(failed_steps.begin(), failed_steps.end(), step) != failed_steps.end())
+      {
+        continue;
+      }
+      std::unique_ptr<Geometry> hull = attempt(step, log, result);
+      if (isSinglePolygon(hull.get()))
+      {
+        hi = step;
+        hi_hull = std::move(hull);
+        return true;
+      }
+      if (hull && hi < 0)
+      {
+        result.hull = std::move(hull);
+        result.step = step;
+      }
+      if (pastDeadline())
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  if (hi < 0)
+  {
+    /*
+     * No single polygon among the probes. If the last ones failed, a step
+     * between them may still be single; otherwise keep the last hull like
+     * the linear search.
+     */
+    if (lo < last_step && !scan(lo, last_step + 1))
+    {
+      stopAtDeadline(result, log);
+      return result;
+    }
+    if (hi < 0)
+    {
+      return result;
+    }
+    result.hull = std::move(hi_hull);
+    result.step = hi;
+    return result;
+  }
+
+  /* Bisection phase */
+  bool out_of_time = false;
+  while (hi - lo > 1)
+  {
+    int mid = lo + (hi - lo) / 2;
+    std::unique_ptr<Geometry> hull = attempt(mid, log, result);
+    if (isSinglePolygon(hull.get()))
+    {
+      hi = mid;
+      hi_hull = std::move(hull);
+    }
+    else if (hull)
+    {
+      lo = mid;
+    }
+    else if (!pastDeadline())
+    {
+      log << "Step " << mid << " failed, trying the remaining steps below " << hi << " in turn" << "\n";
+      failed_steps.push_back(mid);
+      out_of_time = !scan(lo, hi);
+      break;
+    }
+    if (pastDeadline())
+    {
+      /* The smallest single-polygon step found so far */
+      out_of_time = hi - lo > 1;
+      break;
+    }
+  }
+
+  result.hull = std::move(hi_hull);
+  result.step = hi;
+  if (out_of_time)
+  {
+    stopAtDeadline(result, log);
+  }
+  return result;
+}
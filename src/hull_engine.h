@@ -0,0 +1,143 @@
+/*
+ * Adaptive-threshold concave hull search over the polygons of one feature.
+ *
+ * Wraps ConcaveHullOfPolygons::concaveHullByLength: the threshold starts at
+ * `initial_threshold` and grows by `increment` per step until the hull is a
+ * single polygon (or `max_attempts` steps have been tried). The steps are
+ * tried on one triangulation of the feature (HullTriangulation), so GEOS
+ * normally computes a single hull per feature.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include <geos/geom/Geometry.h>
+
+struct HullParameters
+{
+  float initial_threshold; // Maximum edge length of the first attempt (input units)
+  float increment;         // Added to the threshold on every retry (input units)
+  int max_attempts;        // Number of threshold steps that may be tried
+  bool is_tight;           // Keep boundary tight to input polygons
+  bool is_holes_allowed;   // Allow holes in the hull
+  float meters_per_unit;   // Only used to log thresholds in meters
+
+  /* Threshold of the given step, accumulated in float exactly like the original retry loop */
+  float thresholdForStep(int step) const;
+};
+
+/* Strategy for finding the smallest threshold step that yields a single polygon */
+enum class SearchStrategy
+{
+  Linear, // Try every step in turn, up to max_attempts
+  Bisect  // Double the step until a single polygon is found, then bisect the bracket
+};
+
+struct HullSearchResult
+{
+  std::unique_ptr<geos::geom::Geometry> hull; // Single-polygon hull, or the last hull computed if none was found
+  int step = 0;                               // Threshold step that produced `hull`
+  int attempts = 0;                           // Number of hull computations
+  int failed_attempts = 0;                    // ... that threw (robustness failures) instead of returning a hull
+  int skipped_steps = 0;                      // Steps ruled out without computing a hull
+  int eroded_step = -1;                       // First single-polygon step of the triangulation (-1 = none or failed)
+  double hull_seconds = 0.0;                  // Wall time spent inside concaveHullByLength
+  double triangulation_seconds = 0.0;         // ... triangulating once and eroding per step
+  bool timed_out = false;                     // Stopped at the deadline; `hull` is the best one found by then
+  bool convex_fallback = false;               // Timed out without any hull: `hull` is the input's convex hull
+};
+
+bool isSinglePolygon(const geos::geom::Geometry *hull);
+
+/*
+ * Smallest part distance at which one group of parts spans the envelope of
+ * `polygons` (see HullEngine). Depends on the geometry only, so it can be
+ * shared by searches with different parameters.
+ */
+double computeMinSingleThreshold(const geos::geom::Geometry *polygons);
+
+/*
+ * Let HullEngine deadlines cancel a running concaveHullByLength. GEOS calls
+ * one process-wide interrupt callback at the checkpoints of its long loops;
+ * the callback installed here interrupts the calling thread if that
+ * thread's search is past its deadline, so other workers carry on. Call it
+ * before the worker threads start.
+ */
+void installHullInterruptCallback();
+
+/*
+ * Hull engine for one feature.
+ *
+ * GEOS rebuilds its constrained Delaunay triangulation on every
+ * concaveHullByLength call. search() builds it once (HullTriangulation),
+ * erodes it at every step to find the smallest threshold that leaves one
+ * polygon, and has GEOS compute the hull of that step only. If GEOS
+ * disagrees, because it failed there or eroded differently, the step by
+ * step search of `strategy` decides as before.
+ *
+ * Before that, a cheaper bound rules out the steps at which the hull can't
+ * possibly be a single polygon, for the search and for callers of hullAt().
+ *
+ * Every hull edge that is not an input edge joins two input vertices, and
+ * edges longer than the threshold are eroded from the outside in. The outer
+ * boundary of a single-polygon hull therefore only steps between parts that
+ * are at most `threshold` apart, and every other part lies inside the
+ * envelope of the parts on that boundary. Running Kruskal over the part
+ * distances gives the first merge distance at which one group of parts spans
+ * the whole envelope; every step below it is known to leave several
+ * components and is skipped without calling GEOS.
+ */
+class HullEngine
+{
+public:
+  HullEngine(const geos::geom::Geometry *polygons, const HullParameters &params);
+
+  /* Same, with computeMinSingleThreshold(polygons) already known */
+  HullEngine(const geos::geom::Geometry *polygons, const HullParameters &params, double min_single_threshold);
+
+  /* Lower bound on any threshold that yields a single polygon (input units) */
+  double minSingleThreshold() const { return min_single_threshold_; }
+
+  /* First step whose threshold reaches minSingleThreshold() */
+  int firstViableStep() const { return first_viable_step_; }
+
+  /* Concave hull at one threshold step; null if GEOS failed */
+  std::unique_ptr<geos::geom::Geometry> hullAt(int step, std::ostream &log) const;
+
+  /*
+   * Give up searching at `deadline` (time budget): the hull being computed
+   * is cancelled, and search() returns the best hull found so far, or the
+   * convex hull of the input if there is none.
+   */
+  void setDeadline(std::chrono::steady_clock::time_point deadline);
+
+  /* Off: search() computes hulls step by step without the triangulation, e.g. to check it */
+  void setTriangulated(bool triangulated) { triangulated_ = triangulated; }
+
+  /* Smallest step below max_attempts whose hull is a single polygon */
+  HullSearchResult search(SearchStrategy strategy, std::ostream &log) const;
+
+private:
+  bool pastDeadline() const;
+
+  /* First step from `start` whose eroded triangulation is one polygon; max_attempts if none, -1 if unknown */
+  int erodedSingleStep(int start, HullSearchResult &result, std::ostream &log) const;
+
+  /* Finish a search that ran out of time */
+  void stopAtDeadline(HullSearchResult &result, std::ostream &log) const;
+
+  /* hullAt() as one attempt of `result`, timed */
+  std::unique_ptr<geos::geom::Geometry> attempt(int step, std::ostream &log, HullSearchResult &result) const;
+
+  const geos::geom::Geometry *polygons_;
+  HullParameters params_;
+  double min_single_threshold_ = 0.0;
+  int first_viable_step_ = 0;
+  bool triangulated_ = true;
+  bool has_deadline_ = false;
+  std::chrono::steady_clock::time_point deadline_;
+};
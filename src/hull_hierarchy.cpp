@@ -0,0 +1,346 @@
+#include "hull_hierarchy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <geos/algorithm/distance/DiscreteHausdorffDistance.h>
+#include <geos/geom/Envelope.h>
+#include <geos/geom/GeometryFactory.h>
+#include <geos/geom/MultiPolygon.h>
+#include <geos/index/strtree/TemplateSTRtree.h>
+#include <geos/io/WKBReader.h>
+#include <geos/io/WKBWriter.h>
+
+#include "profile_report.h"
+
+using namespace geos::geom;
+using geos::index::strtree::TemplateSTRtree;
+using geos::io::WKBReader;
+using geos::io::WKBWriter;
+
+std::string HierarchySettings::describe() const
+{
+  if (!enabled())
+  {
+    return "off";
+  }
+  return std::to_string(min_parts) + ":" + std::to_string(cluster_parts);
+}
+
+namespace
+{
+  bool parseCount(const std::string &text, size_t &count)
+  {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+    {
+      return false;
+    }
+    count = std::stoul(text);
+    return count > 1;
+  }
+
+  size_t findRoot(std::vector<size_t> &parent, size_t i)
+  {
+    while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+
+  /* Halve `parts` at the median along the longer side of their envelope until every group fits */
+  void splitCluster(std::vector<size_t> parts, const std::vector<const Envelope *> &envelopes, size_t cluster_parts,
+                    std::vector<std::vector<size_t>> &clusters)
+  {
+    if (parts.size() <= cluster_parts)
+    {
+      clusters.push_back(std::move(parts));
+      return;
+    }
+    Envelope extent;
+    for (size_t part : parts)
+    {
+      extent.expandToInclude(envelopes[part]);
+    }
+    bool along_x = extent.getWidth() >= extent.getHeight();
+    auto center = [&](size_t part)
+    {
+      const Envelope &e = *envelopes[part];
+      return along_x ? e.getMinX() + e.getMaxX() : e.getMinY() + e.getMaxY();
+    };
+    auto middle = parts.begin() + parts.size() / 2;
+    std::nth_element(parts.begin(), middle, parts.end(), [&](size_t a, size_t b)
+                     { return center(a) < center(b); });
+    std::vector<size_t> upper(middle, parts.end());
+    parts.erase(middle, parts.end());
+    splitCluster(std::move(parts), envelopes, cluster_parts, clusters);
+    splitCluster(std::move(upper), envelopes, cluster_parts, clusters);
+  }
+
+  std::string wkbOf(const Geometry &geometry)
+  {
+    std::ostringstream wkb;
+    WKBWriter writer;
+    writer.write(geometry, wkb);
+    return wkb.str();
+  }
+
+  std::unique_ptr<Geometry> readWkb(const std::string &wkb, const GeometryFactory &factory)
+  {
+    std::istringstream in(wkb);
+    WKBReader reader(factory);
+    return reader.read(in);
+  }
+
+  /* One cluster's search, passed between threads as WKB so no geometry crosses factories */
+  struct ClusterTask
+  {
+    std::string input_wkb;
+    std::string hull_wkb; // Empty if the search found no hull
+    int attempts = 0;
+    int failed_attempts = 0;
+    double hull_seconds = 0.0;
+    double triangulation_seconds = 0.0;
+    bool timed_out = false; // Cut short by the deadline, or never started
+    std::exception_ptr error;
+  };
+
+  void searchCluster(ClusterTask &task, const HullParameters &params, SearchStrategy strategy,
+                     std::optional<std::chrono::steady_clock::time_point> deadline)
+  {
+    if (deadline && std::chrono::steady_clock::now() >= *deadline)
+    {
+      task.timed_out = true;
+      return;
+    }
+    GeometryFactory::Ptr factory = GeometryFactory::create();
+    std::unique_ptr<Geometry> cluster = readWkb(task.input_wkb, *factory);
+    std::ostream null_log(nullptr);
+    HullEngine engine(cluster.get(), params);
+    if (deadline)
+    {
+      engine.setDeadline(*deadline);
+    }
+    HullSearchResult search = engine.search(strategy, null_log);
+    task.attempts = search.attempts;
+    task.failed_attempts = search.failed_attempts;
+    task.hull_seconds = search.hull_seconds;
+    task.triangulation_seconds = search.triangulation_seconds;
+    task.timed_out = search.timed_out;
+    if (search.hull)
+    {
+      task.hull_wkb = wkbOf(*search.hull);
+    }
+  }
+}
+
+HierarchySettings parseHierarchySettings(const std::string &text)
+{
+  HierarchySettings settings;
+  if (text == "off")
+  {
+    return settings;
+  }
+  size_t colon = text.find(':');
+  bool valid = parseCount(text.substr(0, colon), settings.min_parts) &&
+               (colon == std::string::npos || parseCount(text.substr(colon + 1), settings.cluster_parts));
+  if (!valid)
+  {
+    throw std::runtime_error("Invalid value for --hierarchical (expected off, N or N:K with N, K > 1): " + text);
+  }
+  return settings;
+}
+
+std::vector<std::vector<size_t>> clusterParts(const Geometry *polygons, double link_distance, size_t cluster_parts)
+{
+  size_t n = polygons->getNumGeometries();
+  std::vector<const Envelope *> envelopes(n);
+  TemplateSTRtree<size_t> tree;
+  for (size_t i = 0; i < n; ++i)
+  {
+    envelopes[i] = polygons->getGeometryN(i)->getEnvelopeInternal();
+    tree.insert(envelopes[i], i);
+  }
+
+  /* Parts whose envelopes are within the link distance end up in the same group */
+  std::vector<size_t> parent(n);
+  std::iota(parent.begin(), parent.end(), 0);
+  for (size_t i = 0; i < n; ++i)
+  {
+    Envelope probe = *envelopes[i];
+    probe.expandBy(link_distance);
+    tree.query(probe, [&](size_t j)
+               {
+                 if (j > i && envelopes[i]->distance(*envelopes[j]) <= link_distance)
+                 {
+                   parent[findRoot(parent, j)] = findRoot(parent, i);
+                 } });
+  }
+
+  std::vector<std::vector<size_t>> groups(n);
+  for (size_t i = 0; i < n; ++i)
+  {
+    groups[findRoot(parent, i)].push_back(i);
+  }
+  std::vector<std::vector<size_t>> clusters;
+  for (std::vector<size_t> &group : groups)
+  {
+    if (!group.empty())
+    {
+      splitCluster(std::move(group), envelopes, cluster_parts, clusters);
+    }
+  }
+  return clusters;
+}
+
+HierarchicalSearch hierarchicalHullSearch(const Geometry *polygons, const HullParameters &params,
+                                          SearchStrategy strategy, const HierarchySettings &settings,
+                                          unsigned threads,
+                                          std::optional<std::chrono::steady_clock::time_point> deadline,
+                                          std::ostream &log)
+{
+  HierarchicalSearch hierarchical;
+  std::vector<std::vector<size_t>> clusters = clusterParts(polygons, params.initial_threshold, settings.cluster_parts);
+  hierarchical.clusters = clusters.size();
+  for (const std::vector<size_t> &cluster : clusters)
+  {
+    hierarchical.largest_cluster = std::max(hierarchical.largest_cluster, cluster.size());
+  }
+  if (clusters.size() < 2)
+  {
+    /* Nothing to split: the direct search */
+    log << "Hierarchical: " << polygons->getNumGeometries() << " parts form a single cluster\n";
+    HullEngine engine(polygons, params);
+    if (deadline)
+    {
+      engine.setDeadline(*deadline);
+    }
+    hierarchical.result = engine.search(strategy, log);
+    hierarchical.merged_polygons = polygons->getNumGeometries();
+    return hierarchical;
+  }
+
+  const GeometryFactory &factory = *polygons->getFactory();
+  std::vector<ClusterTask> tasks(clusters.size());
+  for (size_t c = 0; c < clusters.size(); ++c)
+  {
+    std::vector<std::unique_ptr<Geometry>> parts;
+    for (size_t part : clusters[c])
+    {
+      parts.push_back(polygons->getGeometryN(part)->clone());
+    }
+    tasks[c].input_wkb = wkbOf(*factory.createMultiPolygon(std::move(parts)));
+  }
+
+  /* Largest clusters first, so one of them doesn't start last */
+  std::vector<size_t> order(tasks.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+            { return clusters[a].size() > clusters[b].size(); });
+
+  auto clusters_start = std::chrono::steady_clock::now();
+  std::atomic<size_t> next_task{0};
+  auto run_tasks = [&]()
+  {
+    for (size_t i = next_task++; i < order.size(); i = next_task++)
+    {
+      ClusterTask &task = tasks[order[i]];
+      try
+      {
+        searchCluster(task, params, strategy, deadline);
+      }
+      catch (...)
+      {
+        task.error = std::current_exception();
+      }
+    }
+  };
+  std::vector<std::thread> helpers;
+  for (unsigned t = 1; t < std::min<size_t>(std::max(1u, threads), tasks.size()); ++t)
+  {
+    helpers.emplace_back(run_tasks);
+  }
+  run_tasks();
+  for (std::thread &helper : helpers)
+  {
+    helper.join();
+  }
+  hierarchical.clusters_ms = millisecondsSince(clusters_start);
+
+  /* Cluster hulls back on the caller's factory; a cluster without any hull keeps its parts */
+  std::vector<std::unique_ptr<Geometry>> cluster_hulls;
+  int attempts = 0;
+  int failed_attempts = 0;
+  double hull_seconds = 0.0;
+  double triangulation_seconds = 0.0;
+  bool clusters_timed_out = false;
+  for (ClusterTask &task : tasks)
+  {
+    if (task.error)
+    {
+      std::rethrow_exception(task.error);
+    }
+    attempts += task.attempts;
+    failed_attempts += task.failed_attempts;
+    hull_seconds += task.hull_seconds;
+    triangulation_seconds += task.triangulation_seconds;
+    clusters_timed_out |= task.timed_out;
+  }
+  if (deadline && std::chrono::steady_clock::now() >= *deadline)
+  {
+    /* No time left for the union and the final search: the fallback of HullEngine without any hull */
+    log << "Time budget exceeded in the cluster searches after " << attempts << " attempt(s), using the convex hull\n";
+    hierarchical.result.hull = polygons->convexHull();
+    hierarchical.result.timed_out = true;
+    hierarchical.result.convex_fallback = true;
+    hierarchical.result.attempts = attempts;
+    hierarchical.result.failed_attempts = failed_attempts;
+    hierarchical.result.hull_seconds = hull_seconds;
+    hierarchical.result.triangulation_seconds = triangulation_seconds;
+    hierarchical.merged_polygons = polygons->getNumGeometries();
+    return hierarchical;
+  }
+  for (ClusterTask &task : tasks)
+  {
+    cluster_hulls.push_back(readWkb(task.hull_wkb.empty() ? task.input_wkb : task.hull_wkb, factory));
+  }
+  std::unique_ptr<Geometry> merged = factory.buildGeometry(std::move(cluster_hulls))->Union();
+  hierarchical.merged_polygons = merged->getNumGeometries();
+  log << "Hierarchical: " << polygons->getNumGeometries() << " parts in " << clusters.size()
+      << " clusters (largest: " << hierarchical.largest_cluster << " parts), " << attempts
+      << " cluster attempt(s) in " << hierarchical.clusters_ms << " ms, merged into "
+      << hierarchical.merged_polygons << " polygon(s)\n";
+
+  HullEngine engine(merged.get(), params);
+  if (deadline)
+  {
+    engine.setDeadline(*deadline);
+  }
+  hierarchical.result = engine.search(strategy, log);
+  /* A cluster hull cut short makes the final hull a best effort too, and keeps it out of the cache */
+  hierarchical.result.timed_out |= clusters_timed_out;
+  hierarchical.result.attempts += attempts;
+  hierarchical.result.failed_attempts += failed_attempts;
+  hierarchical.result.hull_seconds += hull_seconds;
+  hierarchical.result.triangulation_seconds += triangulation_seconds;
+  return hierarchical;
+}
+
+HullComparison compareHulls(const Geometry &hierarchical, const Geometry &direct, double meters_per_unit)
+{
+  HullComparison comparison;
+  double direct_area = direct.getArea();
+  double union_area = hierarchical.Union(&direct)->getArea();
+  comparison.area_ratio = direct_area > 0.0 ? hierarchical.getArea() / direct_area : 0.0;
+  comparison.iou = union_area > 0.0 ? hierarchical.intersection(&direct)->getArea() / union_area : 0.0;
+  comparison.hausdorff_m =
+      geos::algorithm::distance::DiscreteHausdorffDistance::distance(hierarchical, direct) * meters_per_unit;
+  return comparison;
+}
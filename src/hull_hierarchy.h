@@ -0,0 +1,93 @@
+/*
+ * Hierarchical concave hulls of very large multipolygons (--hierarchical).
+ *
+ * The cost of concaveHullByLength grows with the triangulation of every
+ * part at once, so a feature made of hundreds of parts (Broadway Malls,
+ * the Greenbelt) spends most of the run in a few huge triangulations, and
+ * every retried threshold pays it again. Instead, its parts are clustered
+ * by envelope proximity: an STRtree over the part envelopes links parts
+ * that are closer than the first hull threshold, and groups larger than
+ * `cluster_parts` are split at the median along their longer side. Each
+ * cluster gets its own threshold search, on threads of its own; the
+ * cluster hulls are unioned (neighbouring clusters can overlap) and the
+ * final search runs over those few, much simpler polygons.
+ *
+ * The result is not the direct hull: the clusters are closed off before
+ * the final hull sees them. compareHulls() measures the difference for
+ * --hierarchical-check.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <geos/geom/Geometry.h>
+
+#include "hull_engine.h"
+
+/* Default largest cluster, in parts */
+const size_t DEFAULT_HIERARCHY_CLUSTER_PARTS = 32;
+
+struct HierarchySettings
+{
+  size_t min_parts = 0; // Features with at least this many parts are hulled hierarchically (0 = off)
+  size_t cluster_parts = DEFAULT_HIERARCHY_CLUSTER_PARTS;
+
+  bool enabled() const { return min_parts > 0; }
+  bool appliesTo(const geos::geom::Geometry *polygons) const
+  {
+    return enabled() && polygons->getNumGeometries() >= min_parts;
+  }
+
+  /* "off" or "N:K"; also identifies the settings in hull cache keys */
+  std::string describe() const;
+};
+
+/* Parse "off", "N" or "N:K" (N = minimum parts, K = largest cluster) */
+HierarchySettings parseHierarchySettings(const std::string &text);
+
+/* Indices of the parts of `polygons` in each cluster */
+std::vector<std::vector<size_t>> clusterParts(const geos::geom::Geometry *polygons, double link_distance,
+                                              size_t cluster_parts);
+
+struct HierarchicalSearch
+{
+  HullSearchResult result; // The final search; attempts and hull time include the clusters'
+  size_t clusters = 0;
+  size_t largest_cluster = 0;   // Parts
+  size_t merged_polygons = 0;   // Polygons the final search ran over
+  double clusters_ms = 0.0;     // Wall time of the cluster searches
+};
+
+/*
+ * Concave hull of `polygons` through per-cluster hulls, with the search of
+ * `HullEngine::search` at every level. Clusters are hulled on up to
+ * `threads` threads, each with its own GeometryFactory (factories aren't
+ * thread-safe); the result is created by the factory of `polygons`.
+ *
+ * A `deadline` (--time-budget) covers the whole search: cluster searches
+ * stop at it as HullEngine::setDeadline does, clusters not started by then
+ * keep their parts, and if the final search can't start in time the result
+ * is the convex hull of `polygons`. The result is then marked timed out.
+ */
+HierarchicalSearch hierarchicalHullSearch(const geos::geom::Geometry *polygons, const HullParameters &params,
+                                          SearchStrategy strategy, const HierarchySettings &settings,
+                                          unsigned threads,
+                                          std::optional<std::chrono::steady_clock::time_point> deadline,
+                                          std::ostream &log);
+
+/* How a hierarchical hull differs from the direct one */
+struct HullComparison
+{
+  double area_ratio = 0.0;  // Hierarchical area / direct area
+  double iou = 0.0;         // Intersection area / union area
+  double hausdorff_m = 0.0; // Discrete Hausdorff distance
+};
+
+HullComparison compareHulls(const geos::geom::Geometry &hierarchical, const geos::geom::Geometry &direct,
+                            double meters_per_unit);
@@ -0,0 +1,54 @@
+/*
+ * Concave hull settings of the 1a stage, shared by the stage and its
+ * benchmark so both compute exactly the same hulls.
+ */
+
+#pragma once
+
+#include "hull_engine.h"
+
+const float METERS_PER_DEGREE = 111319.9;
+const float CONCAVE_HULL_LENGTH_THRESHOLD_METERS = 50.0;
+const float CONCAVE_HULL_LENGTH_THRESHOLD = CONCAVE_HULL_LENGTH_THRESHOLD_METERS / METERS_PER_DEGREE;
+const float CONCAVE_HULL_LENGTH_INCREMENT_METERS = 20.0;
+const float CONCAVE_HULL_LENGTH_INCREMENT = CONCAVE_HULL_LENGTH_INCREMENT_METERS / METERS_PER_DEGREE;
+const int MAX_ATTEMPTS = 100; // Maximum number of threshold increments to try
+
+const HullParameters HULL_PARAMETERS = {
+    CONCAVE_HULL_LENGTH_THRESHOLD,
+    CONCAVE_HULL_LENGTH_INCREMENT,
+    MAX_ATTEMPTS,
+    true,  /* isTight - keep boundary tight to input polygons */
+    false, /* isHolesAllowed - don't allow holes in the hull */
+    METERS_PER_DEGREE};
+
+/* The same search in meters, for hulls computed in UTM 18N (--projection utm18n) */
+const HullParameters HULL_PARAMETERS_METERS = {
+    CONCAVE_HULL_LENGTH_THRESHOLD_METERS,
+    CONCAVE_HULL_LENGTH_INCREMENT_METERS,
+    MAX_ATTEMPTS,
+    true,
+    false,
+    1.0f};
+
+/*
+ * A search starting at `threshold_m` in steps of `increment_m`, in degrees,
+ * or in meters for `projected` input; the defaults give HULL_PARAMETERS and
+ * HULL_PARAMETERS_METERS exactly.
+ */
+inline HullParameters hullParametersInMeters(float threshold_m, float increment_m, int max_attempts, bool projected,
+                                             bool is_tight = true, bool is_holes_allowed = false)
+{
+  if (projected)
+  {
+    return {threshold_m, increment_m, max_attempts, is_tight, is_holes_allowed, 1.0f};
+  }
+  return {threshold_m / METERS_PER_DEGREE, increment_m / METERS_PER_DEGREE, max_attempts, is_tight, is_holes_allowed,
+          METERS_PER_DEGREE};
+}
+
+/* Threshold (in meters) of the given search step */
+inline double thresholdMetersForStep(int step)
+{
+  return CONCAVE_HULL_LENGTH_THRESHOLD_METERS + step * CONCAVE_HULL_LENGTH_INCREMENT_METERS;
+}
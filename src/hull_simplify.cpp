@@ -0,0 +1,127 @@
+#include "hull_simplify.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include <geos/simplify/TopologyPreservingSimplifier.h>
+
+using namespace geos::geom;
+using geos::simplify::TopologyPreservingSimplifier;
+
+/* Bisection steps when searching a tolerance for the vertex budget */
+const int BUDGET_SEARCH_ITERATIONS = 10;
+
+std::string SimplifySettings::describe() const
+{
+  std::ostringstream out;
+  switch (mode)
+  {
+  case SimplifyMode::Off:
+    out << "off";
+    break;
+  case SimplifyMode::Threshold:
+    out << "threshold:" << fraction;
+    break;
+  case SimplifyMode::Budget:
+    out << "budget:" << vertex_budget;
+    break;
+  }
+  return out.str();
+}
+
+namespace
+{
+  bool parseFraction(const std::string &text, double &fraction)
+  {
+    char *end = nullptr;
+    fraction = std::strtod(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && fraction > 0.0 && fraction <= 1.0;
+  }
+
+  bool parseCount(const std::string &text, size_t &count)
+  {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos)
+    {
+      return false;
+    }
+    count = std::stoul(text);
+    return count > 0;
+  }
+}
+
+SimplifySettings parseSimplifySettings(const std::string &text)
+{
+  SimplifySettings settings;
+  size_t colon = text.find(':');
+  std::string mode = text.substr(0, colon);
+  bool has_value = colon != std::string::npos;
+  std::string value = has_value ? text.substr(colon + 1) : "";
+
+  bool valid = false;
+  if (mode == "off")
+  {
+    valid = !has_value;
+  }
+  else if (mode == "threshold")
+  {
+    settings.mode = SimplifyMode::Threshold;
+    valid = !has_value || parseFraction(value, settings.fraction);
+  }
+  else if (mode == "budget")
+  {
+    settings.mode = SimplifyMode::Budget;
+    valid = has_value && parseCount(value, settings.vertex_budget);
+  }
+  if (!valid)
+  {
+    throw std::runtime_error("Invalid value for --simplify (expected off, threshold[:F] with 0 < F <= 1, or budget:N): " + text);
+  }
+  return settings;
+}
+
+SimplifiedInput simplifyForHull(const Geometry *polygons, const SimplifySettings &settings, const HullParameters &params)
+{
+  SimplifiedInput result;
+  result.vertices_before = polygons->getNumPoints();
+  result.vertices_after = result.vertices_before;
+
+  if (settings.mode == SimplifyMode::Threshold)
+  {
+    result.tolerance = settings.fraction * params.initial_threshold;
+    result.geometry = TopologyPreservingSimplifier::simplify(polygons, result.tolerance);
+  }
+  else if (settings.mode == SimplifyMode::Budget && result.vertices_before > settings.vertex_budget)
+  {
+    /* Vertex count only falls as the tolerance grows, so bisect for the smallest one within budget */
+    double lo = 0.0;
+    double hi = params.initial_threshold;
+    result.geometry = TopologyPreservingSimplifier::simplify(polygons, hi);
+    result.tolerance = hi;
+    if (result.geometry->getNumPoints() <= settings.vertex_budget)
+    {
+      for (int i = 0; i < BUDGET_SEARCH_ITERATIONS; ++i)
+      {
+        double mid = (lo + hi) / 2.0;
+        std::unique_ptr<Geometry> candidate = TopologyPreservingSimplifier::simplify(polygons, mid);
+        if (candidate->getNumPoints() <= settings.vertex_budget)
+        {
+          hi = mid;
+          result.geometry = std::move(candidate);
+          result.tolerance = mid;
+        }
+        else
+        {
+          lo = mid;
+        }
+      }
+    }
+    /* Otherwise stay at the initial threshold: simplifying further would outgrow the hull's own edges */
+  }
+
+  if (result.geometry)
+  {
+    result.vertices_after = result.geometry->getNumPoints();
+  }
+  return result;
+}
@@ -0,0 +1,55 @@
+/*
+ * Optional pre-simplification of hull inputs (--simplify).
+ *
+ * Hull cost grows with the number of input vertices, but a hull whose
+ * shortest allowed edge is tens of meters can't follow boundary detail much
+ * finer than that. Inputs are simplified with TopologyPreservingSimplifier
+ * (parts and holes are kept valid and never collapse) at a tolerance tied to
+ * the first hull threshold, either as a fixed fraction of it or as the
+ * smallest tolerance that brings a feature under a vertex budget. Only the
+ * hull input is simplified; the output features keep their original geometry.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <geos/geom/Geometry.h>
+
+#include "hull_engine.h"
+
+/* Default tolerance of the threshold mode, as a fraction of the first hull threshold */
+const double DEFAULT_SIMPLIFY_FRACTION = 0.1;
+
+enum class SimplifyMode
+{
+  Off,
+  Threshold, // tolerance = fraction * initial threshold
+  Budget     // smallest tolerance (up to the initial threshold) that meets the vertex budget
+};
+
+struct SimplifySettings
+{
+  SimplifyMode mode = SimplifyMode::Off;
+  double fraction = DEFAULT_SIMPLIFY_FRACTION;
+  size_t vertex_budget = 0;
+
+  /* "off", "threshold:F" or "budget:N"; also identifies the settings in hull cache keys */
+  std::string describe() const;
+};
+
+/* Parse "off", "threshold", "threshold:F" or "budget:N" */
+SimplifySettings parseSimplifySettings(const std::string &text);
+
+struct SimplifiedInput
+{
+  std::unique_ptr<geos::geom::Geometry> geometry; // Null when the input is used as-is
+  double tolerance = 0.0;                         // Input units
+  size_t vertices_before = 0;
+  size_t vertices_after = 0;
+};
+
+SimplifiedInput simplifyForHull(const geos::geom::Geometry *polygons, const SimplifySettings &settings,
+                                const HullParameters &params);
@@ -0,0 +1,62 @@
+#include "hull_snap.h"
+
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+#include <geos/geom/PrecisionModel.h>
+#include <geos/precision/GeometryPrecisionReducer.h>
+
+using namespace geos::geom;
+using geos::precision::GeometryPrecisionReducer;
+
+std::string SnapSettings::describe() const
+{
+  if (!enabled())
+  {
+    return "off";
+  }
+  std::ostringstream out;
+  out << "grid:" << grid_m;
+  return out.str();
+}
+
+SnapSettings parseSnapSettings(const std::string &text)
+{
+  SnapSettings settings;
+  if (text == "off")
+  {
+    return settings;
+  }
+  char *end = nullptr;
+  settings.grid_m = std::strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0' || !(settings.grid_m > 0.0))
+  {
+    throw std::runtime_error("Invalid value for --snap (expected off or a grid spacing in meters, e.g. 0.01): " + text);
+  }
+  return settings;
+}
+
+SnappedInput snapForHull(const Geometry *polygons, const SnapSettings &settings, const HullParameters &params)
+{
+  SnappedInput result;
+  result.vertices_before = polygons->getNumPoints();
+  result.vertices_after = result.vertices_before;
+  if (!settings.enabled())
+  {
+    return result;
+  }
+
+  /* A fixed precision model's scale is the number of grid cells per unit */
+  result.grid = settings.grid_m / params.meters_per_unit;
+  PrecisionModel grid(1.0 / result.grid);
+  std::unique_ptr<Geometry> snapped = GeometryPrecisionReducer::reduce(*polygons, grid);
+
+  /* A feature smaller than the grid collapses; its hull is computed unsnapped */
+  if (snapped && !snapped->isEmpty())
+  {
+    result.geometry = std::move(snapped);
+    result.vertices_after = result.geometry->getNumPoints();
+  }
+  return result;
+}
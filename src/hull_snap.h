@@ -0,0 +1,48 @@
+/*
+ * Optional snapping of hull inputs to a fixed precision grid (--snap).
+ *
+ * The input is read with a floating precision model, so parts that share a
+ * boundary (digitized twice) meet in vertices that differ by rounding noise
+ * instead of coinciding, and those near-degenerate triangles are what
+ * makes concaveHullByLength throw; every failure costs another attempt at
+ * the next threshold. GeometryPrecisionReducer rounds the hull input to a
+ * grid of `grid_m` meters and repairs whatever the rounding collapses, so
+ * such vertices become identical. The hull is built from input vertices, so
+ * in degrees it lands on the grid as well and its coordinates print with
+ * fewer digits. As with --simplify, the output features keep their original
+ * geometry.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include <geos/geom/Geometry.h>
+
+#include "hull_engine.h"
+
+struct SnapSettings
+{
+  double grid_m = 0.0; // Grid spacing in meters (0 = off)
+
+  bool enabled() const { return grid_m > 0.0; }
+
+  /* "off" or "grid:G"; also identifies the settings in hull cache keys */
+  std::string describe() const;
+};
+
+/* Parse "off" or a grid spacing in meters, e.g. "0.01" (1 cm) */
+SnapSettings parseSnapSettings(const std::string &text);
+
+struct SnappedInput
+{
+  std::unique_ptr<geos::geom::Geometry> geometry; // Null when the input is used as-is
+  double grid = 0.0;                              // Input units
+  size_t vertices_before = 0;
+  size_t vertices_after = 0;
+};
+
+SnappedInput snapForHull(const geos::geom::Geometry *polygons, const SnapSettings &settings,
+                         const HullParameters &params);
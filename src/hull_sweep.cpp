@@ -0,0 +1,161 @@
+#include "hull_sweep.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+/* Keeps the output file names (and the work) of one run reasonable */
+const size_t MAX_SWEEP_CONFIGURATIONS = 64;
+
+std::string SweepConfig::label() const
+{
+  std::ostringstream out;
+  out << "t" << threshold_m;
+  if (!is_tight)
+  {
+    out << "_loose";
+  }
+  if (is_holes_allowed)
+  {
+    out << "_holes";
+  }
+  return out.str();
+}
+
+std::vector<SweepConfig> SweepGrid::configurations(float threshold_m, bool is_tight, bool is_holes_allowed) const
+{
+  std::vector<float> threshold_values = thresholds_m.empty() ? std::vector<float>{threshold_m} : thresholds_m;
+  std::vector<bool> tight_values = tight.empty() ? std::vector<bool>{is_tight} : tight;
+  std::vector<bool> holes_values = holes.empty() ? std::vector<bool>{is_holes_allowed} : holes;
+
+  std::vector<SweepConfig> configs;
+  for (float threshold : threshold_values)
+  {
+    for (bool tight_value : tight_values)
+    {
+      for (bool holes_value : holes_values)
+      {
+        configs.push_back({threshold, tight_value, holes_value});
+      }
+    }
+  }
+  return configs;
+}
+
+namespace
+{
+  std::vector<std::string> splitList(const std::string &text)
+  {
+    std::vector<std::string> items;
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+      items.push_back(item);
+    }
+    return items;
+  }
+
+  bool parseThreshold(const std::string &text, float &threshold)
+  {
+    char *end = nullptr;
+    threshold = std::strtof(text.c_str(), &end);
+    return !text.empty() && *end == '\0' && threshold > 0.0f;
+  }
+
+  bool parseSwitch(const std::string &text, bool &value)
+  {
+    if (text == "yes" || text == "true" || text == "on" || text == "1")
+    {
+      value = true;
+      return true;
+    }
+    if (text == "no" || text == "false" || text == "off" || text == "0")
+    {
+      value = false;
+      return true;
+    }
+    return false;
+  }
+}
+
+void parseSweepAxis(const std::string &text, SweepGrid &grid)
+{
+  size_t equals = text.find('=');
+  std::string axis = text.substr(0, equals);
+  std::vector<std::string> values = equals == std::string::npos ? std::vector<std::string>() : splitList(text.substr(equals + 1));
+
+  bool valid = !values.empty();
+  if (axis == "threshold")
+  {
+    grid.thresholds_m.clear();
+    for (const std::string &value : values)
+    {
+      float threshold = 0.0f;
+      valid = valid && parseThreshold(value, threshold);
+      grid.thresholds_m.push_back(threshold);
+    }
+  }
+  else if (axis == "tight" || axis == "holes")
+  {
+    std::vector<bool> &switches = axis == "tight" ? grid.tight : grid.holes;
+    switches.clear();
+    for (const std::string &value : values)
+    {
+      bool on = false;
+      valid = valid && parseSwitch(value, on);
+      switches.push_back(on);
+    }
+  }
+  else
+  {
+    valid = false;
+  }
+  if (!valid)
+  {
+    throw std::runtime_error("Invalid value for --sweep (expected threshold=M,..., tight=yes|no,... or holes=yes|no,...): " + text);
+  }
+
+  size_t count = std::max<size_t>(grid.thresholds_m.size(), 1) * std::max<size_t>(grid.tight.size(), 1) *
+                 std::max<size_t>(grid.holes.size(), 1);
+  if (count > MAX_SWEEP_CONFIGURATIONS)
+  {
+    throw std::runtime_error("--sweep grid has " + std::to_string(count) + " configurations (at most " +
+                             std::to_string(MAX_SWEEP_CONFIGURATIONS) + ")");
+  }
+
+  /* Configurations are told apart by their labels (and output paths), so no axis may repeat one */
+  std::vector<std::string> labels;
+  for (float threshold : grid.thresholds_m)
+  {
+    labels.push_back(SweepConfig{threshold, true, false}.label());
+  }
+  std::sort(labels.begin(), labels.end());
+  auto repeated = std::adjacent_find(labels.begin(), labels.end());
+  if (repeated != labels.end())
+  {
+    throw std::runtime_error("--sweep threshold values repeat " + repeated->substr(1) +
+                             " (values that print alike would write the same output): " + text);
+  }
+  for (const std::vector<bool> *switches : {&grid.tight, &grid.holes})
+  {
+    if (std::count(switches->begin(), switches->end(), true) > 1 ||
+        std::count(switches->begin(), switches->end(), false) > 1)
+    {
+      throw std::runtime_error("--sweep " + std::string(switches == &grid.tight ? "tight" : "holes") +
+                               " values repeat: " + text);
+    }
+  }
+}
+
+std::string sweepOutputPath(const std::string &path, const SweepConfig &config)
+{
+  size_t slash = path.find_last_of('/');
+  size_t dot = path.find_last_of('.');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash) || dot == slash + 1)
+  {
+    return path + "." + config.label();
+  }
+  return path.substr(0, dot) + "." + config.label() + path.substr(dot);
+}
@@ -0,0 +1,43 @@
+/*
+ * Parameter grid of the --sweep mode.
+ *
+ * A grid has three axes: the initial hull threshold (meters), isTight and
+ * isHolesAllowed. Each `--sweep AXIS=V1,V2,...` sets the values of one
+ * axis, axes that are not given keep the stage's own setting, and the
+ * configurations are the cartesian product in threshold, tight, holes
+ * order. Every configuration gets its own concave hulls output, named
+ * after the configuration's label.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+struct SweepConfig
+{
+  float threshold_m;     // Initial threshold of the adaptive search
+  bool is_tight;         // Keep boundary tight to input polygons
+  bool is_holes_allowed; // Allow holes in the hull
+
+  /* "t50", "t25_loose", "t100_holes", ...; identifies the configuration in outputs */
+  std::string label() const;
+};
+
+struct SweepGrid
+{
+  std::vector<float> thresholds_m;
+  std::vector<bool> tight;
+  std::vector<bool> holes;
+
+  bool empty() const { return thresholds_m.empty() && tight.empty() && holes.empty(); }
+
+  /* Every configuration of the grid; missing axes take the given defaults */
+  std::vector<SweepConfig> configurations(float threshold_m, bool is_tight, bool is_holes_allowed) const;
+};
+
+/* Set one axis of `grid` from "threshold=25,50,...", "tight=yes,no" or "holes=no,yes" */
+void parseSweepAxis(const std::string &text, SweepGrid &grid);
+
+/* `path` with ".<label>" inserted before its extension */
+std::string sweepOutputPath(const std::string &path, const SweepConfig &config);
@@ -0,0 +1,299 @@
+#include "hull_triangulation.h"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+#include <geos/geom/Coordinate.h>
+#include <geos/geom/CoordinateSequence.h>
+#include <geos/geom/Envelope.h>
+#include <geos/geom/GeometryFactory.h>
+#include <geos/geom/LinearRing.h>
+#include <geos/geom/Polygon.h>
+#include <geos/triangulate/polygon/ConstrainedDelaunayTriangulator.h>
+#include <geos/triangulate/tri/Tri.h>
+#include <geos/triangulate/tri/TriList.h>
+
+using namespace geos::geom;
+using geos::triangulate::polygon::ConstrainedDelaunayTriangulator;
+using geos::triangulate::tri::Tri;
+using geos::triangulate::tri::TriIndex;
+using geos::triangulate::tri::TriList;
+
+/* ConcaveHullOfPolygons::FRAME_EXPAND_FACTOR: the frame is the envelope grown by 4 diameters */
+const double FRAME_EXPAND_FACTOR = 4.0;
+
+namespace
+{
+  using VertexShells = std::map<std::pair<double, double>, std::vector<int>>;
+
+  const std::vector<int> *shellsAt(const VertexShells &shells, double x, double y)
+  {
+    auto found = shells.find({x, y});
+    return found == shells.end() ? nullptr : &found->second;
+  }
+
+  /* Shell that all of `vertices` lie on, or -1 */
+  int commonShell(const VertexShells &shells, const std::vector<std::pair<double, double>> &vertices)
+  {
+    const std::vector<int> *first = shellsAt(shells, vertices[0].first, vertices[0].second);
+    if (!first)
+    {
+      return -1;
+    }
+    for (int shell : *first)
+    {
+      bool on_all = true;
+      for (size_t v = 1; v < vertices.size() && on_all; ++v)
+      {
+        const std::vector<int> *others = shellsAt(shells, vertices[v].first, vertices[v].second);
+        on_all = others && std::find(others->begin(), others->end(), shell) != others->end();
+      }
+      if (on_all)
+      {
+        return shell;
+      }
+    }
+    return -1;
+  }
+
+  int findRoot(std::vector<int> &parent, int i)
+  {
+    while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  }
+}
+
+HullTriangulation::HullTriangulation(const Geometry *polygons)
+{
+  if (polygons->isEmpty() || polygons->getArea() == 0.0)
+  {
+    return; // concaveHullByLength returns an empty hull without triangulating
+  }
+
+  /* The frame of ConcaveHullOfPolygons::createFrame, with the shells as holes */
+  const GeometryFactory *factory = polygons->getFactory();
+  Envelope frame_envelope = *polygons->getEnvelopeInternal();
+  frame_envelope.expandBy(FRAME_EXPAND_FACTOR * frame_envelope.getDiameter());
+  std::unique_ptr<Geometry> frame_geometry = factory->toGeometry(&frame_envelope);
+  const LinearRing *frame_shell = static_cast<const Polygon *>(frame_geometry.get())->getExteriorRing();
+
+  VertexShells vertex_shells;
+  std::vector<std::unique_ptr<LinearRing>> shells;
+  shells_ = polygons->getNumGeometries();
+  for (size_t i = 0; i < shells_; ++i)
+  {
+    const LinearRing *shell = static_cast<const Polygon *>(polygons->getGeometryN(i))->getExteriorRing();
+    const CoordinateSequence *coords = shell->getCoordinatesRO();
+    for (size_t c = 0; c < coords->size(); ++c)
+    {
+      std::vector<int> &on = vertex_shells[{coords->getX(c), coords->getY(c)}];
+      if (on.empty() || on.back() != static_cast<int>(i))
+      {
+        on.push_back(static_cast<int>(i));
+      }
+    }
+    shells.push_back(shell->clone());
+  }
+  std::unique_ptr<Polygon> frame = factory->createPolygon(frame_shell->clone(), std::move(shells));
+
+  TriList<Tri> tris;
+  ConstrainedDelaunayTriangulator::triangulatePolygon(frame.get(), tris);
+
+  std::unordered_map<const Tri *, int> index_of;
+  for (size_t t = 0; t < tris.size(); ++t)
+  {
+    index_of[tris[t]] = static_cast<int>(t);
+  }
+
+  const CoordinateSequence *corners = frame->getExteriorRing()->getCoordinatesRO();
+  triangles_.resize(tris.size());
+  for (size_t t = 0; t < tris.size(); ++t)
+  {
+    const Tri *tri = tris[t];
+    Triangle &triangle = triangles_[t];
+    std::vector<std::pair<double, double>> vertices;
+    for (TriIndex i = 0; i < 3; ++i)
+    {
+      const Tri *adjacent = tri->getAdjacent(i);
+      triangle.adjacent[i] = adjacent ? index_of.at(adjacent) : -1;
+      triangle.adjacent_edge[i] = adjacent ? adjacent->getIndex(tri) : -1;
+      triangle.length[i] = tri->getLength(i);
+      triangle.shell[i] = -1;
+      vertices.push_back({tri->getCoordinate(i).x, tri->getCoordinate(i).y});
+    }
+
+    /* The first frame corner in ring order, as ConcaveHullOfPolygons::vertexIndex finds it */
+    TriIndex corner = -1;
+    for (size_t c = 0; c < corners->size() && corner < 0; ++c)
+    {
+      for (TriIndex i = 0; i < 3 && corner < 0; ++i)
+      {
+        if (vertices[i].first == corners->getX(c) && vertices[i].second == corners->getY(c))
+        {
+          corner = i;
+        }
+      }
+    }
+    triangle.frame = corner >= 0;
+    if (triangle.frame)
+    {
+      triangle.frame_edge = Tri::oppEdge(corner);
+      continue;
+    }
+    triangle.within_shell = commonShell(vertex_shells, vertices) >= 0;
+    for (TriIndex i = 0; i < 3; ++i)
+    {
+      if (triangle.adjacent[i] < 0)
+      {
+        triangle.shell[i] = commonShell(vertex_shells, {vertices[i], vertices[Tri::next(i)]});
+      }
+    }
+  }
+
+  /* A corner triangle only starts the erosion if the triangle across is not a corner triangle too */
+  for (Triangle &triangle : triangles_)
+  {
+    if (triangle.frame && triangle.frame_edge >= 0)
+    {
+      int across = triangle.adjacent[triangle.frame_edge];
+      if (across < 0 || triangles_[across].frame)
+      {
+        triangle.frame_edge = -1;
+      }
+    }
+  }
+}
+
+/*
+ * ConcaveHullOfPolygons::buildHullTris on a copy of the adjacency: a FIFO
+ * of border triangles, each keeping the edge it was last reached through,
+ * seeded by the frame corner triangles in triangulation order. With holes
+ * allowed, interior triangles with a long edge then seed the same erosion.
+ */
+size_t HullTriangulation::componentsAt(double max_edge_length, bool is_tight, bool is_holes_allowed) const
+{
+  int n = static_cast<int>(triangles_.size());
+  if (n == 0)
+  {
+    return 0;
+  }
+  std::vector<bool> removed(n, false);
+  std::vector<int> border_edge(n, -1);
+  std::deque<int> border;
+
+  auto adjacent = [&](int t, int edge)
+  {
+    int across = triangles_[t].adjacent[edge];
+    return across >= 0 && !removed[across] ? across : -1;
+  };
+  auto addBorder = [&](int t, int edge)
+  {
+    int across = adjacent(t, edge);
+    if (across >= 0)
+    {
+      border.push_back(across);
+      border_edge[across] = triangles_[t].adjacent_edge[edge];
+    }
+  };
+  auto removable = [&](int t)
+  {
+    if (is_tight && triangles_[t].within_shell)
+    {
+      return true;
+    }
+    return border_edge[t] >= 0 && triangles_[t].length[border_edge[t]] > max_edge_length;
+  };
+  auto erode = [&]()
+  {
+    while (!border.empty())
+    {
+      int t = border.front();
+      border.pop_front();
+      if (removed[t] || !removable(t))
+      {
+        continue;
+      }
+      for (int edge = 0; edge < 3; ++edge)
+      {
+        addBorder(t, edge);
+      }
+      removed[t] = true;
+    }
+  };
+
+  for (int t = 0; t < n; ++t)
+  {
+    if (triangles_[t].frame)
+    {
+      if (triangles_[t].frame_edge >= 0)
+      {
+        addBorder(t, triangles_[t].frame_edge);
+      }
+      removed[t] = true;
+    }
+  }
+  erode();
+
+  if (is_holes_allowed)
+  {
+    /* A triangle that isn't a hole seed never becomes one, so one pass in order finds them all */
+    for (int t = 0; t < n; ++t)
+    {
+      if (removed[t])
+      {
+        continue;
+      }
+      bool interior = adjacent(t, 0) >= 0 && adjacent(t, 1) >= 0 && adjacent(t, 2) >= 0;
+      const double *length = triangles_[t].length;
+      if (!interior || std::max({length[0], length[1], length[2]}) <= max_edge_length)
+      {
+        continue;
+      }
+      for (int edge = 0; edge < 3; ++edge)
+      {
+        addBorder(t, edge);
+      }
+      removed[t] = true;
+      erode();
+    }
+  }
+
+  /* Polygons of the union of the remaining triangles and the input: connected through shared edges */
+  std::vector<int> parent(n + shells_);
+  std::iota(parent.begin(), parent.end(), 0);
+  for (int t = 0; t < n; ++t)
+  {
+    if (removed[t])
+    {
+      continue;
+    }
+    for (int edge = 0; edge < 3; ++edge)
+    {
+      int across = triangles_[t].adjacent[edge];
+      int other = across >= 0 ? (removed[across] ? -1 : across)
+                              : (triangles_[t].shell[edge] >= 0 ? n + triangles_[t].shell[edge] : -1);
+      if (other >= 0)
+      {
+        parent[findRoot(parent, other)] = findRoot(parent, t);
+      }
+    }
+  }
+  size_t components = 0;
+  for (int i = 0; i < n + static_cast<int>(shells_); ++i)
+  {
+    if ((i >= n || !removed[i]) && findRoot(parent, i) == i)
+    {
+      components++;
+    }
+  }
+  return components;
+}
@@ -0,0 +1,48 @@
+/*
+ * The triangulation behind ConcaveHullOfPolygons, built once per feature.
+ *
+ * concaveHullByLength triangulates the gaps between the shells of the
+ * polygons inside a frame around their envelope (a constrained Delaunay
+ * triangulation of the frame with the shells as holes), drops the triangles
+ * at the frame corners, erodes triangles from the outside in while the edge
+ * they were reached through is longer than the threshold, and unions what is
+ * left with the polygons. Only the erosion depends on the threshold, and it
+ * is linear in the number of triangles, while the triangulation is nearly
+ * all of the cost. HullTriangulation keeps the triangle adjacency of one
+ * triangulation and replays the erosion on it, in the order GEOS erodes,
+ * for every threshold asked for.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <geos/geom/Geometry.h>
+
+class HullTriangulation
+{
+public:
+  /* Triangulate the gaps between the parts of `polygons` as concaveHullByLength does; throws on GEOS errors */
+  explicit HullTriangulation(const geos::geom::Geometry *polygons);
+
+  /* Number of polygons in concaveHullByLength(polygons, max_edge_length, is_tight, is_holes_allowed) */
+  size_t componentsAt(double max_edge_length, bool is_tight, bool is_holes_allowed) const;
+
+  size_t triangles() const { return triangles_.size(); }
+
+private:
+  struct Triangle
+  {
+    int adjacent[3];      // Triangle across edge i, -1 if the edge lies on a shell or the frame
+    int adjacent_edge[3]; // Index of the shared edge in that triangle
+    int shell[3];         // Shell that edge i lies on, -1 if none
+    double length[3];
+    int frame_edge = -1;        // Frame corner triangles: edge to the border triangle GEOS starts from, if any
+    bool frame = false;          // Has a frame corner as vertex, removed before the erosion
+    bool within_shell = false;   // All vertices on one shell (removable regardless of length when tight)
+  };
+
+  std::vector<Triangle> triangles_;
+  size_t shells_ = 0;
+};
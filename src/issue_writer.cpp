@@ -0,0 +1,130 @@
+#include "issue_writer.h"
+
+#include <fstream>
+#include <stdexcept>
+
+/* For directory creation */
+#if __cplusplus >= 201703L
+#include <filesystem>
+#else
+#include <sys/stat.h>
+#include <sys/types.h>
+#endif
+
+namespace
+{
+  void writeFile(const char *filename, const std::string &content)
+  {
+    std::ofstream file(filename);
+    if (!file.is_open())
+    {
+      throw std::runtime_error(std::string("Could not write to file: ") + filename);
+    }
+    file << content;
+  }
+
+  bool createDirectoryIfNotExists(const std::string &dir_path)
+  {
+#if __cplusplus >= 201703L
+    namespace fs = std::filesystem;
+    if (!fs::exists(dir_path))
+    {
+      return fs::create_directory(dir_path);
+    }
+    return true;
+#else
+    struct stat st = {0};
+    if (stat(dir_path.c_str(), &st) == -1)
+    {
+      return mkdir(dir_path.c_str(), 0700) == 0;
+    }
+    return true;
+#endif
+  }
+}
+
+IssueWriter::IssueWriter(std::string directory) : directory_(std::move(directory))
+{
+  thread_ = std::thread(&IssueWriter::run, this);
+}
+
+IssueWriter::~IssueWriter()
+{
+  try
+  {
+    close();
+  }
+  catch (...)
+  {
+    /* Reported by close() when it is called explicitly */
+  }
+}
+
+std::string IssueWriter::submit(std::string collection_json)
+{
+  std::string path = directory_ + "/issue_" + std::to_string(++count_) + ".geojson";
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.emplace_back(path, std::move(collection_json));
+  }
+  queued_.notify_one();
+  return path;
+}
+
+void IssueWriter::close()
+{
+  if (thread_.joinable())
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closing_ = true;
+    }
+    queued_.notify_one();
+    thread_.join();
+  }
+  if (error_)
+  {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+void IssueWriter::run()
+{
+  bool directory_ready = false;
+  for (;;)
+  {
+    std::pair<std::string, std::string> file;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queued_.wait(lock, [&]
+                   { return closing_ || !queue_.empty(); });
+      if (queue_.empty())
+      {
+        return;
+      }
+      file = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    /* After the first failure the rest is dropped; close() reports it */
+    if (error_)
+    {
+      continue;
+    }
+    try
+    {
+      if (!directory_ready && !createDirectoryIfNotExists(directory_))
+      {
+        throw std::runtime_error("Failed to create directory '" + directory_ + "'");
+      }
+      directory_ready = true;
+      writeFile(file.first.c_str(), file.second);
+    }
+    catch (...)
+    {
+      error_ = std::current_exception();
+    }
+  }
+}
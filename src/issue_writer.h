@@ -0,0 +1,54 @@
+/*
+ * Background writer of the multi-polygon issue files (temp/issue_geojson).
+ *
+ * Every feature whose hull is still a MultiPolygon gets a single-feature
+ * collection of its own, issue_1.geojson, issue_2.geojson, ... in the order
+ * the issues are submitted. The workers already encode the collections, and
+ * the files are written on a thread of their own while the run goes on, so
+ * they take neither a pass of their own once the outputs are done nor time
+ * from the consumer writing them. The directory is created with the first
+ * file.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+
+class IssueWriter
+{
+public:
+  explicit IssueWriter(std::string directory);
+  ~IssueWriter();
+
+  IssueWriter(const IssueWriter &) = delete;
+  IssueWriter &operator=(const IssueWriter &) = delete;
+
+  /* Queue the next issue file; returns its path */
+  std::string submit(std::string collection_json);
+
+  /* Wait until every queued file is written; throws the first error */
+  void close();
+
+  /* Number of files submitted so far */
+  size_t count() const { return count_; }
+
+private:
+  void run();
+
+  std::string directory_;
+  size_t count_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable queued_;
+  std::deque<std::pair<std::string, std::string>> queue_; // (path, content)
+  bool closing_ = false;
+  std::exception_ptr error_;
+  std::thread thread_;
+};
@@ -0,0 +1,196 @@
+#include "line_server.h"
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+void serveStream(std::istream &in, std::ostream &out, const LineHandler &handler)
+{
+  std::string line;
+  std::string reply;
+  while (std::getline(in, line))
+  {
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+    if (line.empty())
+    {
+      continue;
+    }
+    bool keep_serving = handler(line, reply);
+    out << reply << '\n';
+    out.flush();
+    if (!keep_serving)
+    {
+      return;
+    }
+  }
+}
+
+namespace
+{
+  /* Write all of `text`; false if the client went away */
+  bool sendAll(int fd, const std::string &text)
+  {
+    size_t sent = 0;
+    while (sent < text.size())
+    {
+      ssize_t n = write(fd, text.data() + sent, text.size() - sent);
+      if (n < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (n <= 0)
+      {
+        return false;
+      }
+      sent += static_cast<size_t>(n);
+    }
+    return true;
+  }
+
+  std::string tooLongError()
+  {
+    return "Request longer than " + std::to_string(MAX_REQUEST_BYTES) + " bytes";
+  }
+
+  /* Answer one line; `sent` is false if the client went away. Returns false once the handler asked to stop */
+  bool serveLine(int fd, std::string line, const LineHandler &handler, const ErrorReply &error_reply, bool &sent)
+  {
+    sent = true;
+    if (!line.empty() && line.back() == '\r')
+    {
+      line.pop_back();
+    }
+    if (line.empty())
+    {
+      return true;
+    }
+    std::string reply;
+    bool keep_serving = true;
+    if (line.size() > MAX_REQUEST_BYTES)
+    {
+      reply = error_reply(tooLongError());
+    }
+    else
+    {
+      keep_serving = handler(line, reply);
+    }
+    reply += '\n';
+    sent = sendAll(fd, reply);
+    return keep_serving;
+  }
+
+  /* Serve one connection; false once the handler asked to stop */
+  bool serveConnection(int fd, const LineHandler &handler, const ErrorReply &error_reply)
+  {
+    std::string buffer;
+    bool discarding = false; // Skipping the rest of a line that was too long
+    bool sent = true;
+    char chunk[65536];
+    for (;;)
+    {
+      ssize_t n = read(fd, chunk, sizeof(chunk));
+      if (n < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (n == 0 && !discarding && !buffer.empty())
+      {
+        /* The client closed its end after a last request without a newline, as getline would take it */
+        return serveLine(fd, std::move(buffer), handler, error_reply, sent);
+      }
+      if (n <= 0)
+      {
+        return true;
+      }
+      buffer.append(chunk, static_cast<size_t>(n));
+
+      size_t start = 0;
+      for (size_t end = buffer.find('\n'); end != std::string::npos; end = buffer.find('\n', start))
+      {
+        std::string line = buffer.substr(start, end - start);
+        start = end + 1;
+        if (discarding)
+        {
+          discarding = false;
+          continue;
+        }
+        bool keep_serving = serveLine(fd, std::move(line), handler, error_reply, sent);
+        if (!sent || !keep_serving)
+        {
+          return keep_serving;
+        }
+      }
+      buffer.erase(0, start);
+
+      /* Don't buffer a line past the limit: answer it now and drop input up to its newline */
+      if (buffer.size() > MAX_REQUEST_BYTES)
+      {
+        buffer.clear();
+        if (!discarding)
+        {
+          discarding = true;
+          if (!sendAll(fd, error_reply(tooLongError()) + '\n'))
+          {
+            return true;
+          }
+        }
+      }
+    }
+  }
+}
+
+void serveUnixSocket(const std::string &path, const LineHandler &handler, const ErrorReply &error_reply)
+{
+  sockaddr_un address{};
+  if (path.size() >= sizeof(address.sun_path))
+  {
+    throw std::runtime_error("Socket path too long: " + path);
+  }
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0)
+  {
+    throw std::runtime_error("Could not create socket: " + std::string(std::strerror(errno)));
+  }
+  unlink(path.c_str());
+  if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 8) != 0)
+  {
+    std::string reason = std::strerror(errno);
+    close(listener);
+    throw std::runtime_error("Could not listen on " + path + ": " + reason);
+  }
+
+  /* A client hanging up mid-reply must not kill the server */
+  std::signal(SIGPIPE, SIG_IGN);
+
+  bool keep_serving = true;
+  while (keep_serving)
+  {
+    int client = accept(listener, nullptr, nullptr);
+    if (client < 0)
+    {
+      if (errno == EINTR)
+      {
+        continue;
+      }
+      std::string reason = std::strerror(errno);
+      close(listener);
+      unlink(path.c_str());
+      throw std::runtime_error("Could not accept on " + path + ": " + reason);
+    }
+    keep_serving = serveConnection(client, handler, error_reply);
+    close(client);
+  }
+  close(listener);
+  unlink(path.c_str());
+}
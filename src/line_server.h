@@ -0,0 +1,35 @@
+/*
+ * Transport of --serve: newline-delimited requests answered by one reply
+ * line each, over stdin/stdout or a Unix domain socket.
+ *
+ * Requests are handled one at a time in arrival order; the handler owns
+ * the protocol, this only frames lines and moves them.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+
+/* Answer one request line (without its newline) in `reply`; return false to stop serving */
+using LineHandler = std::function<bool(const std::string &request, std::string &reply)>;
+
+/* Reply line for a request the transport rejected before the handler saw it */
+using ErrorReply = std::function<std::string(const std::string &error)>;
+
+/* Longest request line a socket client may send; longer ones are answered with an error and skipped */
+const size_t MAX_REQUEST_BYTES = size_t(64) << 20;
+
+/* Serve the lines of `in` until it ends or the handler stops */
+void serveStream(std::istream &in, std::ostream &out, const LineHandler &handler);
+
+/*
+ * Listen on a Unix socket at `path` (replacing a stale socket file) and
+ * serve one connection after another until the handler stops. A request
+ * cut off by the client closing its end is served like one ending in a
+ * newline. Throws if the socket can't be set up.
+ */
+void serveUnixSocket(const std::string &path, const LineHandler &handler, const ErrorReply &error_reply);
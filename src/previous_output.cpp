@@ -0,0 +1,82 @@
+#include "previous_output.h"
+
+#include <sstream>
+#include <unordered_set>
+
+#include <geos/io/GeoJSONReader.h>
+#include <geos/io/WKBConstants.h>
+#include <geos/io/WKBReader.h>
+#include <geos/io/WKBWriter.h>
+
+#include "feature_io.h"
+#include "geojson_feature.h"
+#include "hull_cache.h"
+
+using namespace geos::geom;
+using namespace geos::io;
+
+PreviousOutput::PreviousOutput(const std::string &path)
+{
+  GeometryFactory::Ptr factory = GeometryFactory::create();
+  std::unique_ptr<FeatureReader> reader = openFeatureReader(path);
+  FeatureDecoder decoder(featureFormatForPath(path), *factory);
+  GeoJSONReader geometry_reader(*factory);
+  WKBWriter wkb_writer;
+  wkb_writer.setByteOrder(WKBConstants::wkbNDR);
+
+  /* An id that appears twice can't tell its features apart; neither is reused */
+  std::unordered_set<std::string> duplicates;
+  std::string_view record;
+  while (reader->next(record))
+  {
+    GeoJSONFeatureCollection parsed = decoder.decode(record);
+    const GeoJSONFeature &feature = parsed.getFeatures().at(0);
+    const auto &properties = feature.getProperties();
+    auto id_it = properties.find(":id");
+    auto hull_it = properties.find("concave_hull_polygon");
+    auto threshold_it = properties.find("concave_hull_threshold_m");
+    auto settings_it = properties.find("concave_hull_settings");
+    if (id_it == properties.end() || !id_it->second.isString() || !feature.getGeometry() ||
+        hull_it == properties.end() || threshold_it == properties.end() || !threshold_it->second.isNumber() ||
+        settings_it == properties.end() || !settings_it->second.isString())
+    {
+      continue;
+    }
+    const std::string &id = id_it->second.getString();
+    if (entries_.count(id))
+    {
+      duplicates.insert(id);
+      continue;
+    }
+
+    /* Properties hold the hull as a GeoJSON geometry object */
+    std::unique_ptr<Geometry> hull = geometry_reader.read(propertyValueJson(hull_it->second));
+    std::ostringstream hull_wkb;
+    wkb_writer.write(*hull, hull_wkb);
+
+    Entry &entry = entries_[id];
+    entry.digest = geometryDigest(*feature.getGeometry());
+    entry.hull_wkb = hull_wkb.str();
+    entry.threshold_m = threshold_it->second.getNumber();
+    entry.settings = settings_it->second.getString();
+  }
+  for (const std::string &id : duplicates)
+  {
+    entries_.erase(id);
+  }
+}
+
+bool PreviousOutput::find(const std::string &id, const Geometry &geometry, const std::string &settings,
+                          const GeometryFactory &factory, PreviousHull &previous) const
+{
+  auto it = entries_.find(id);
+  if (it == entries_.end() || it->second.settings != settings || it->second.digest != geometryDigest(geometry))
+  {
+    return false;
+  }
+  const std::string &wkb = it->second.hull_wkb;
+  WKBReader reader(factory);
+  previous.hull = reader.read(reinterpret_cast<const unsigned char *>(wkb.data()), wkb.size());
+  previous.threshold_m = it->second.threshold_m;
+  return previous.hull != nullptr;
+}
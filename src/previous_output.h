@@ -0,0 +1,58 @@
+/*
+ * Hulls of an earlier run, for --previous.
+ *
+ * The original + concave hull output of a run carries every feature's
+ * input geometry next to its `concave_hull_polygon` and
+ * `concave_hull_threshold_m`, and `concave_hull_settings`, the
+ * HullCache::settingsKey of the settings that produced the hull. Loading it
+ * indexes those hulls by ":id" and a digest of the input geometry, so a run
+ * on a new Parks_Properties release only computes hulls for features that
+ * were added or whose geometry changed. Hulls made with other settings, or
+ * written before the settings were recorded, are computed again. Property changes still reach the outputs, since
+ * reused features are encoded again from the new input.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <geos/geom/Geometry.h>
+#include <geos/geom/GeometryFactory.h>
+
+struct PreviousHull
+{
+  std::unique_ptr<geos::geom::Geometry> hull;
+  double threshold_m = 0.0; // concave_hull_threshold_m of the previous output
+};
+
+class PreviousOutput
+{
+public:
+  /* Index the output at `path` (GeoJSON or feature container); throws if it can't be read */
+  explicit PreviousOutput(const std::string &path);
+
+  /*
+   * The previous hull of feature `id`, created by `factory`, if the feature
+   * had one, `geometry` is unchanged and the hull was made with `settings`
+   * (HullCache::settingsKey); false otherwise. Safe to call from several
+   * workers at once.
+   */
+  bool find(const std::string &id, const geos::geom::Geometry &geometry, const std::string &settings,
+            const geos::geom::GeometryFactory &factory, PreviousHull &previous) const;
+
+  /* Features with a reusable hull */
+  size_t size() const { return entries_.size(); }
+
+private:
+  struct Entry
+  {
+    std::string digest;   // geometryDigest of the input geometry
+    std::string settings; // concave_hull_settings
+    std::string hull_wkb; // The hull, as little-endian WKB
+    double threshold_m = 0.0;
+  };
+
+  std::unordered_map<std::string, Entry> entries_;
+};
@@ -0,0 +1,247 @@
+#include "profile_report.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+
+#include <sys/resource.h>
+
+#include <geos/version.h>
+#include <geos/io/GeoJSONWriter.h> /* Brings in the vendored nlohmann JSON */
+
+using ordered_json = geos_nlohmann::ordered_json;
+
+/* Percentiles reported for every metric */
+const double REPORT_PERCENTILES[] = {50.0, 90.0, 95.0, 99.0};
+
+double millisecondsSince(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+double percentileOfSorted(const std::vector<double> &sorted_values, double percentile)
+{
+  if (sorted_values.empty())
+  {
+    return 0.0;
+  }
+  size_t rank = static_cast<size_t>(std::ceil(percentile / 100.0 * sorted_values.size()));
+  return sorted_values[std::min(std::max<size_t>(rank, 1), sorted_values.size()) - 1];
+}
+
+size_t peakMemoryBytes()
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+  {
+    return 0;
+  }
+#ifdef __APPLE__
+  return static_cast<size_t>(usage.ru_maxrss); // Bytes on macOS
+#else
+  return static_cast<size_t>(usage.ru_maxrss) * 1024; // Kilobytes on Linux
+#endif
+}
+
+namespace
+{
+  /* Nearest-rank percentiles plus min/max/mean of `values` */
+  ordered_json distribution(std::vector<double> values)
+  {
+    ordered_json out = ordered_json::object();
+    if (values.empty())
+    {
+      return out;
+    }
+    std::sort(values.begin(), values.end());
+
+    double sum = 0.0;
+    for (double v : values)
+    {
+      sum += v;
+    }
+    out["min"] = values.front();
+    out["mean"] = sum / values.size();
+    for (double p : REPORT_PERCENTILES)
+    {
+      out["p" + std::to_string(static_cast<int>(p))] = percentileOfSorted(values, p);
+    }
+    out["max"] = values.back();
+    return out;
+  }
+
+  template <typename Field>
+  std::vector<double> collect(const std::vector<const FeatureProfile *> &features, Field field)
+  {
+    std::vector<double> values;
+    values.reserve(features.size());
+    for (const FeatureProfile *f : features)
+    {
+      values.push_back(static_cast<double>(f->*field));
+    }
+    return values;
+  }
+}
+
+void ProfileReport::write(const std::string &path, const ProfileRunInfo &run) const
+{
+  ordered_json report;
+  report["geos_version"] = GEOS_VERSION;
+  report["input"] = run.input;
+  report["threads"] = run.threads;
+  report["search"] = run.search;
+  report["arena"] = run.arena;
+
+  /* Percentiles are over features that needed a hull computation; the rest only pass through */
+  std::vector<const FeatureProfile *> computed;
+  double decode_ms = 0.0, snap_ms = 0.0, simplify_ms = 0.0, bound_ms = 0.0, triangulation_ms = 0.0, hull_ms = 0.0,
+         serialize_ms = 0.0, worker_ms = 0.0;
+  size_t hulled = 0, cache_hits = 0, reused = 0, attempts = 0, arena_allocations = 0, arena_overflows = 0;
+  size_t timed_out = 0, convex_fallbacks = 0, failed_attempts = 0, hierarchical = 0;
+  for (const FeatureProfile &f : features_)
+  {
+    decode_ms += f.decode_ms;
+    snap_ms += f.snap_ms;
+    simplify_ms += f.simplify_ms;
+    bound_ms += f.bound_ms;
+    triangulation_ms += f.triangulation_ms;
+    hull_ms += f.hull_ms;
+    serialize_ms += f.serialize_ms;
+    worker_ms += f.total_ms;
+    attempts += f.attempts;
+    failed_attempts += f.failed_attempts;
+    hierarchical += f.clusters > 0;
+    arena_allocations += f.arena_allocations;
+    arena_overflows += f.arena_overflows;
+    timed_out += f.timed_out;
+    convex_fallbacks += f.convex_hull;
+    if (f.hulled)
+    {
+      hulled++;
+      if (f.reused)
+      {
+        reused++;
+      }
+      else if (f.cache_hit)
+      {
+        cache_hits++;
+      }
+      else
+      {
+        computed.push_back(&f);
+      }
+    }
+  }
+
+  ordered_json &totals = report["totals"];
+  totals["features"] = features_.size();
+  totals["hulled"] = hulled;
+  totals["cache_hits"] = cache_hits;
+  totals["reused"] = reused;
+  totals["timed_out"] = timed_out;
+  totals["convex_fallbacks"] = convex_fallbacks;
+  totals["attempts"] = attempts;
+  totals["failed_attempts"] = failed_attempts;
+  totals["hierarchical"] = hierarchical;
+  totals["wall_ms"] = run.wall_ms;
+  totals["worker_ms"] = worker_ms;
+  totals["decode_ms"] = decode_ms;
+  totals["snap_ms"] = snap_ms;
+  totals["simplify_ms"] = simplify_ms;
+  totals["bound_ms"] = bound_ms;
+  totals["triangulation_ms"] = triangulation_ms;
+  totals["hull_ms"] = hull_ms;
+  totals["serialize_ms"] = serialize_ms;
+  totals["peak_memory_bytes"] = run.peak_memory_bytes;
+  if (run.arena)
+  {
+    totals["arena_allocations"] = arena_allocations;
+    totals["arena_overflows"] = arena_overflows;
+  }
+
+  ordered_json &percentiles = report["percentiles"];
+  percentiles["features"] = computed.size();
+  percentiles["total_ms"] = distribution(collect(computed, &FeatureProfile::total_ms));
+  percentiles["triangulation_ms"] = distribution(collect(computed, &FeatureProfile::triangulation_ms));
+  percentiles["hull_ms"] = distribution(collect(computed, &FeatureProfile::hull_ms));
+  percentiles["serialize_ms"] = distribution(collect(computed, &FeatureProfile::serialize_ms));
+  percentiles["attempts"] = distribution(collect(computed, &FeatureProfile::attempts));
+  percentiles["vertices"] = distribution(collect(computed, &FeatureProfile::vertices));
+  percentiles["polygons"] = distribution(collect(computed, &FeatureProfile::polygons));
+  if (run.arena)
+  {
+    percentiles["arena_allocations"] = distribution(collect(computed, &FeatureProfile::arena_allocations));
+    percentiles["arena_peak_bytes"] = distribution(collect(computed, &FeatureProfile::arena_peak_bytes));
+  }
+
+  ordered_json features = ordered_json::array();
+  for (const FeatureProfile &f : features_)
+  {
+    ordered_json entry;
+    entry["index"] = f.index;
+    entry["id"] = f.id;
+    entry["name"] = f.name;
+    entry["hulled"] = f.hulled;
+    entry["cache_hit"] = f.cache_hit;
+    entry["reused"] = f.reused;
+    entry["timed_out"] = f.timed_out;
+    entry["convex_fallback"] = f.convex_hull;
+    entry["vertices"] = f.vertices;
+    entry["polygons"] = f.polygons;
+    entry["attempts"] = f.attempts;
+    entry["failed_attempts"] = f.failed_attempts;
+    if (f.unsnapped_attempts >= 0)
+    {
+      entry["unsnapped_attempts"] = f.unsnapped_attempts;
+      entry["unsnapped_failed_attempts"] = f.unsnapped_failed_attempts;
+    }
+    entry["skipped_steps"] = f.skipped_steps;
+    entry["threshold_m"] = f.threshold_m;
+    entry["hull_vertices"] = f.hull_vertices;
+    entry["simplify_tolerance_m"] = f.simplify_tolerance_m;
+    if (f.hausdorff_m >= 0.0)
+    {
+      entry["hausdorff_m"] = f.hausdorff_m;
+    }
+    entry["decode_ms"] = f.decode_ms;
+    entry["project_ms"] = f.project_ms;
+    entry["augment_ms"] = f.augment_ms;
+    entry["snap_ms"] = f.snap_ms;
+    entry["simplify_ms"] = f.simplify_ms;
+    if (f.clusters > 0)
+    {
+      entry["clusters"] = f.clusters;
+      entry["hierarchical_ms"] = f.hierarchical_ms;
+    }
+    if (f.direct_ms >= 0.0)
+    {
+      entry["direct_ms"] = f.direct_ms;
+      entry["direct_area_ratio"] = f.direct_area_ratio;
+      entry["direct_iou"] = f.direct_iou;
+      entry["direct_hausdorff_m"] = f.direct_hausdorff_m;
+    }
+    entry["bound_ms"] = f.bound_ms;
+    entry["triangulation_ms"] = f.triangulation_ms;
+    entry["hull_ms"] = f.hull_ms;
+    entry["analysis_ms"] = f.analysis_ms;
+    entry["serialize_ms"] = f.serialize_ms;
+    entry["total_ms"] = f.total_ms;
+    if (run.arena)
+    {
+      entry["arena_allocations"] = f.arena_allocations;
+      entry["arena_peak_bytes"] = f.arena_peak_bytes;
+      entry["arena_overflows"] = f.arena_overflows;
+    }
+    features.push_back(std::move(entry));
+  }
+  report["features"] = std::move(features);
+
+  std::ofstream file(path);
+  if (!file.is_open())
+  {
+    throw std::runtime_error("Could not write to file: " + path);
+  }
+  /* Names come from the input as they are; replace invalid UTF-8 rather than lose the report */
+  file << report.dump(2, ' ', false, ordered_json::error_handler_t::replace) << std::endl;
+}
@@ -0,0 +1,90 @@
+/*
+ * Per-feature instrumentation for --profile.
+ *
+ * Workers fill in one FeatureProfile per feature; the main thread collects
+ * them in input order and writes a JSON report with every feature plus
+ * run-wide totals and percentiles, so the parks driving the tail latency can
+ * be found and runs can be compared across GEOS versions.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+struct FeatureProfile
+{
+  size_t index = 0;          // Position in the input
+  std::string id;            // ":id" property, if any
+  std::string name;          // "eapply" property, if any
+  bool hulled = false;       // MultiPolygon replaced by its concave hull
+  bool cache_hit = false;    // Hull came from the hull cache
+  bool reused = false;       // Hull came from the --previous output
+  bool timed_out = false;    // Hull search stopped by --time-budget
+  bool convex_hull = false;  // ... before any hull, so the convex hull was used
+  size_t vertices = 0;       // Input vertices
+  size_t polygons = 0;       // Input polygons
+  int attempts = 0;          // concaveHullByLength calls
+  int failed_attempts = 0;   // ... that threw
+  int unsnapped_attempts = -1;        // Attempts of the unsnapped search (--snap-check; -1 = not checked)
+  int unsnapped_failed_attempts = -1; // ... and how many of them threw
+  int skipped_steps = 0;     // Threshold steps ruled out by the lower bound or the triangulation
+  double threshold_m = 0.0;  // Threshold that produced the hull
+  size_t hull_vertices = 0;  // Vertices given to the hull engine (after --simplify)
+  double simplify_tolerance_m = 0.0; // Tolerance --simplify used (0 = not simplified)
+  double hausdorff_m = -1.0; // Distance to the hull of the unsimplified input (--simplify-check; -1 = not checked)
+  double decode_ms = 0.0;    // Parsing the input record
+  double project_ms = 0.0;   // Projecting the input (--projection, --stage augment)
+  double augment_ms = 0.0;   // The 0c fields (--stage augment)
+  double snap_ms = 0.0;      // Snapping the hull input to the precision grid (--snap)
+  double simplify_ms = 0.0;  // Pre-simplification of the hull input
+  size_t clusters = 0;       // Part clusters hulled separately (--hierarchical; 0 = hulled directly)
+  double hierarchical_ms = 0.0;      // Wall time of the hierarchical search
+  double direct_ms = -1.0;           // Wall time of the direct search (--hierarchical-check; -1 = not checked)
+  double direct_area_ratio = -1.0;   // Hierarchical hull area / direct hull area
+  double direct_iou = -1.0;          // Intersection over union of the two hulls
+  double direct_hausdorff_m = -1.0;  // Hausdorff distance between them
+  double bound_ms = 0.0;     // Lower bound on the threshold
+  double triangulation_ms = 0.0; // Triangulating once and eroding per step
+  double hull_ms = 0.0;      // Inside concaveHullByLength
+  double analysis_ms = 0.0;  // The 2a shape metrics (--output-analysis)
+  double serialize_ms = 0.0; // Encoding the output records
+  double total_ms = 0.0;     // Everything a worker spends on the feature
+  size_t arena_allocations = 0; // Allocations served by the worker's arena (--arena)
+  size_t arena_peak_bytes = 0;  // Arena bytes the feature used
+  size_t arena_overflows = 0;   // Allocations that didn't fit in the arena
+};
+
+/* Milliseconds elapsed since `start` */
+double millisecondsSince(std::chrono::steady_clock::time_point start);
+
+/* Nearest-rank percentile (0-100) of ascending `sorted_values`; 0 if empty */
+double percentileOfSorted(const std::vector<double> &sorted_values, double percentile);
+
+/* Peak resident set size of this process, in bytes */
+size_t peakMemoryBytes();
+
+/* Summary of the run the report describes */
+struct ProfileRunInfo
+{
+  unsigned threads = 1;
+  std::string search;
+  std::string input;
+  double wall_ms = 0.0;
+  size_t peak_memory_bytes = 0;
+  bool arena = false; // Features ran on per-worker arenas
+};
+
+class ProfileReport
+{
+public:
+  void add(FeatureProfile profile) { features_.push_back(std::move(profile)); }
+
+  /* Write the report as JSON; throws if the file can't be written */
+  void write(const std::string &path, const ProfileRunInfo &run) const;
+
+private:
+  std::vector<FeatureProfile> features_;
+};
@@ -0,0 +1,176 @@
+#include "projection.h"
+
+#include <cmath>
+#include <vector>
+
+#include <geos/geom/CoordinateSequence.h>
+
+using namespace geos::geom;
+
+/* WGS84 ellipsoid */
+const double WGS84_SEMI_MAJOR_AXIS = 6378137.0;
+const double WGS84_FLATTENING = 1.0 / 298.257223563;
+
+/* Newton iterations for the conformal latitude in inverse(); 3 reach full double precision */
+const int INVERSE_LATITUDE_ITERATIONS = 3;
+
+const double DEGREES_TO_RADIANS = M_PI / 180.0;
+
+TransverseMercator::TransverseMercator(double central_meridian, double scale_factor, double false_easting,
+                                       double false_northing)
+    : central_meridian_(central_meridian * DEGREES_TO_RADIANS),
+      scale_factor_(scale_factor),
+      false_easting_(false_easting),
+      false_northing_(false_northing)
+{
+  double f = WGS84_FLATTENING;
+  double n = f / (2.0 - f);
+  double n2 = n * n, n3 = n2 * n, n4 = n3 * n, n5 = n4 * n, n6 = n5 * n;
+  e_ = std::sqrt(f * (2.0 - f));
+
+  double rectifying_radius = WGS84_SEMI_MAJOR_AXIS / (1.0 + n) * (1.0 + n2 / 4.0 + n4 / 64.0 + n6 / 256.0);
+  scaled_radius_ = scale_factor_ * rectifying_radius;
+
+  alpha_[0] = n / 2 - 2 * n2 / 3 + 5 * n3 / 16 + 41 * n4 / 180 - 127 * n5 / 288 + 7891 * n6 / 37800;
+  alpha_[1] = 13 * n2 / 48 - 3 * n3 / 5 + 557 * n4 / 1440 + 281 * n5 / 630 - 1983433 * n6 / 1935360;
+  alpha_[2] = 61 * n3 / 240 - 103 * n4 / 140 + 15061 * n5 / 26880 + 167603 * n6 / 181440;
+  alpha_[3] = 49561 * n4 / 161280 - 179 * n5 / 168 + 6601661 * n6 / 7257600;
+  alpha_[4] = 34729 * n5 / 80640 - 3418889 * n6 / 1995840;
+  alpha_[5] = 212378941 * n6 / 319334400;
+
+  beta_[0] = n / 2 - 2 * n2 / 3 + 37 * n3 / 96 - n4 / 360 - 81 * n5 / 512 + 96199 * n6 / 604800;
+  beta_[1] = n2 / 48 + n3 / 15 - 437 * n4 / 1440 + 46 * n5 / 105 - 1118711 * n6 / 3870720;
+  beta_[2] = 17 * n3 / 480 - 37 * n4 / 840 - 209 * n5 / 4480 + 5569 * n6 / 90720;
+  beta_[3] = 4397 * n4 / 161280 - 11 * n5 / 504 - 830251 * n6 / 7257600;
+  beta_[4] = 4583 * n5 / 161280 - 108847 * n6 / 3991680;
+  beta_[5] = 20648693 * n6 / 638668800;
+}
+
+const TransverseMercator &TransverseMercator::utm18n()
+{
+  static const TransverseMercator projection(-75.0, 0.9996, 500000.0, 0.0);
+  return projection;
+}
+
+void TransverseMercator::forward(double *x, double *y, size_t count) const
+{
+  for (size_t i = 0; i < count; ++i)
+  {
+    double lambda = x[i] * DEGREES_TO_RADIANS - central_meridian_;
+    double sin_phi = std::sin(y[i] * DEGREES_TO_RADIANS);
+
+    /* Conformal latitude, as tan */
+    double t = std::sinh(std::atanh(sin_phi) - e_ * std::atanh(e_ * sin_phi));
+    double xi_prime = std::atan2(t, std::cos(lambda));
+    double eta_prime = std::atanh(std::sin(lambda) / std::sqrt(1.0 + t * t));
+
+    double xi = xi_prime;
+    double eta = eta_prime;
+    for (int j = 0; j < ORDER; ++j)
+    {
+      double k = 2.0 * (j + 1);
+      xi += alpha_[j] * std::sin(k * xi_prime) * std::cosh(k * eta_prime);
+      eta += alpha_[j] * std::cos(k * xi_prime) * std::sinh(k * eta_prime);
+    }
+
+    x[i] = false_easting_ + scaled_radius_ * eta;
+    y[i] = false_northing_ + scaled_radius_ * xi;
+  }
+}
+
+void TransverseMercator::inverse(double *x, double *y, size_t count) const
+{
+  double e2 = e_ * e_;
+  for (size_t i = 0; i < count; ++i)
+  {
+    double xi = (y[i] - false_northing_) / scaled_radius_;
+    double eta = (x[i] - false_easting_) / scaled_radius_;
+
+    double xi_prime = xi;
+    double eta_prime = eta;
+    for (int j = 0; j < ORDER; ++j)
+    {
+      double k = 2.0 * (j + 1);
+      xi_prime -= beta_[j] * std::sin(k * xi) * std::cosh(k * eta);
+      eta_prime -= beta_[j] * std::cos(k * xi) * std::sinh(k * eta);
+    }
+
+    double sinh_eta = std::sinh(eta_prime);
+    double cos_xi = std::cos(xi_prime);
+    double tau_prime = std::sin(xi_prime) / std::sqrt(sinh_eta * sinh_eta + cos_xi * cos_xi);
+    double lambda = std::atan2(sinh_eta, cos_xi);
+
+    /* Solve for tan(phi) from the conformal latitude (Karney 2011, eqs. 19-21) */
+    double tau = tau_prime;
+    for (int iteration = 0; iteration < INVERSE_LATITUDE_ITERATIONS; ++iteration)
+    {
+      double tau_hyp = std::sqrt(1.0 + tau * tau);
+      double sigma = std::sinh(e_ * std::atanh(e_ * tau / tau_hyp));
+      double tau_i = tau * std::sqrt(1.0 + sigma * sigma) - sigma * tau_hyp;
+      tau += (tau_prime - tau_i) / std::sqrt(1.0 + tau_i * tau_i) * (1.0 + (1.0 - e2) * tau * tau) /
+             ((1.0 - e2) * tau_hyp);
+    }
+
+    x[i] = (lambda + central_meridian_) / DEGREES_TO_RADIANS;
+    y[i] = std::atan(tau) / DEGREES_TO_RADIANS;
+  }
+}
+
+namespace
+{
+  /* Transforms each coordinate sequence as a whole, through x/y scratch arrays */
+  class ProjectionFilter : public CoordinateSequenceFilter
+  {
+  public:
+    ProjectionFilter(const TransverseMercator &projection, bool to_projected)
+        : projection_(projection), to_projected_(to_projected) {}
+
+    void filter_rw(CoordinateSequence &sequence, std::size_t index) override
+    {
+      if (index != 0)
+      {
+        return; // Done with the whole sequence at index 0
+      }
+      size_t count = sequence.size();
+      x_.resize(count);
+      y_.resize(count);
+      for (size_t i = 0; i < count; ++i)
+      {
+        x_[i] = sequence.getX(i);
+        y_[i] = sequence.getY(i);
+      }
+      if (to_projected_)
+      {
+        projection_.forward(x_.data(), y_.data(), count);
+      }
+      else
+      {
+        projection_.inverse(x_.data(), y_.data(), count);
+      }
+      for (size_t i = 0; i < count; ++i)
+      {
+        sequence.setOrdinate(i, CoordinateSequence::X, x_[i]);
+        sequence.setOrdinate(i, CoordinateSequence::Y, y_[i]);
+      }
+    }
+
+    bool isDone() const override { return false; }
+    bool isGeometryChanged() const override { return true; }
+
+  private:
+    const TransverseMercator &projection_;
+    bool to_projected_;
+    std::vector<double> x_;
+    std::vector<double> y_;
+  };
+}
+
+std::unique_ptr<Geometry> projectGeometry(const Geometry &geometry, const TransverseMercator &projection,
+                                          bool to_projected)
+{
+  std::unique_ptr<Geometry> projected = geometry.clone();
+  ProjectionFilter filter(projection, to_projected);
+  projected->apply_rw(filter);
+  projected->geometryChanged();
+  return projected;
+}
@@ -0,0 +1,242 @@
+#include "ring_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <geos/geom/CoordinateSequence.h>
+#include <geos/geom/LinearRing.h>
+#include <geos/geom/Polygon.h>
+
+using namespace geos::geom;
+
+/* Independent partial sums per kernel: one AVX2 register of doubles, two NEON ones */
+const size_t LANES = 4;
+
+namespace
+{
+  /* Sum of term(i) for i in [0, count), over LANES partial sums */
+  template <typename Term>
+  double laneSum(size_t count, Term term)
+  {
+    double lanes[LANES] = {};
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES)
+    {
+      for (size_t lane = 0; lane < LANES; ++lane)
+      {
+        lanes[lane] += term(i + lane);
+      }
+    }
+    double sum = 0.0;
+    for (; i < count; ++i)
+    {
+      sum += term(i);
+    }
+    for (size_t lane = 0; lane < LANES; ++lane)
+    {
+      sum += lanes[lane];
+    }
+    return sum;
+  }
+
+  void appendRing(const LinearRing *ring, FlatPolygons &polygons)
+  {
+    const CoordinateSequence *coordinates = ring->getCoordinatesRO();
+    size_t count = coordinates->size();
+    for (size_t i = 0; i < count; ++i)
+    {
+      polygons.x.push_back(coordinates->getX(i));
+      polygons.y.push_back(coordinates->getY(i));
+    }
+    polygons.ring_starts.push_back(polygons.x.size());
+  }
+
+  void appendPolygon(const Polygon *polygon, FlatPolygons &polygons)
+  {
+    appendRing(polygon->getExteriorRing(), polygons);
+    for (size_t i = 0; i < polygon->getNumInteriorRing(); ++i)
+    {
+      appendRing(polygon->getInteriorRingN(i), polygons);
+    }
+    polygons.polygon_rings.push_back(polygons.ring_starts.size() - 1);
+  }
+
+  size_t ringSize(const FlatPolygons &polygons, size_t ring)
+  {
+    return polygons.ring_starts[ring + 1] - polygons.ring_starts[ring];
+  }
+}
+
+FlatPolygons flattenPolygons(const Geometry &geometry)
+{
+  FlatPolygons polygons;
+  polygons.ring_starts.push_back(0);
+  polygons.polygon_rings.push_back(0);
+  polygons.x.reserve(geometry.getNumPoints());
+  polygons.y.reserve(geometry.getNumPoints());
+  if (geometry.getGeometryTypeId() == GEOS_POLYGON)
+  {
+    appendPolygon(static_cast<const Polygon *>(&geometry), polygons);
+  }
+  else if (geometry.getGeometryTypeId() == GEOS_MULTIPOLYGON)
+  {
+    for (size_t i = 0; i < geometry.getNumGeometries(); ++i)
+    {
+      appendPolygon(static_cast<const Polygon *>(geometry.getGeometryN(i)), polygons);
+    }
+  }
+  return polygons;
+}
+
+double ringDoubleSignedArea(const double *x, const double *y, size_t count)
+{
+  if (count < 3)
+  {
+    return 0.0;
+  }
+  double x0 = x[0];
+  double y0 = y[0];
+  return laneSum(count - 1, [&](size_t i)
+                 { return (x[i] - x0) * (y[i + 1] - y0) - (x[i + 1] - x0) * (y[i] - y0); });
+}
+
+double ringLength(const double *x, const double *y, size_t count)
+{
+  if (count < 2)
+  {
+    return 0.0;
+  }
+  return laneSum(count - 1, [&](size_t i)
+                 {
+                   double dx = x[i + 1] - x[i];
+                   double dy = y[i + 1] - y[i];
+                   return std::sqrt(dx * dx + dy * dy); });
+}
+
+double polygonArea(const FlatPolygons &polygons, size_t polygon)
+{
+  double area = 0.0;
+  for (size_t ring = polygons.polygon_rings[polygon]; ring < polygons.polygon_rings[polygon + 1]; ++ring)
+  {
+    size_t start = polygons.ring_starts[ring];
+    double ring_area =
+        std::abs(ringDoubleSignedArea(&polygons.x[start], &polygons.y[start], ringSize(polygons, ring))) / 2.0;
+    area += ring == polygons.polygon_rings[polygon] ? ring_area : -ring_area;
+  }
+  return area;
+}
+
+double totalArea(const FlatPolygons &polygons)
+{
+  double area = 0.0;
+  for (size_t polygon = 0; polygon < polygons.polygonCount(); ++polygon)
+  {
+    area += polygonArea(polygons, polygon);
+  }
+  return area;
+}
+
+double totalLength(const FlatPolygons &polygons)
+{
+  double length = 0.0;
+  for (size_t ring = 0; ring + 1 < polygons.ring_starts.size(); ++ring)
+  {
+    size_t start = polygons.ring_starts[ring];
+    length += ringLength(&polygons.x[start], &polygons.y[start], ringSize(polygons, ring));
+  }
+  return length;
+}
+
+Envelope envelopeOf(const FlatPolygons &polygons)
+{
+  size_t count = polygons.x.size();
+  if (count == 0)
+  {
+    return Envelope();
+  }
+  const double *x = polygons.x.data();
+  const double *y = polygons.y.data();
+  const double inf = std::numeric_limits<double>::infinity();
+  double min_x[LANES], max_x[LANES], min_y[LANES], max_y[LANES];
+  std::fill(min_x, min_x + LANES, inf);
+  std::fill(min_y, min_y + LANES, inf);
+  std::fill(max_x, max_x + LANES, -inf);
+  std::fill(max_y, max_y + LANES, -inf);
+  size_t i = 0;
+  for (; i + LANES <= count; i += LANES)
+  {
+    for (size_t lane = 0; lane < LANES; ++lane)
+    {
+      min_x[lane] = std::min(min_x[lane], x[i + lane]);
+      max_x[lane] = std::max(max_x[lane], x[i + lane]);
+      min_y[lane] = std::min(min_y[lane], y[i + lane]);
+      max_y[lane] = std::max(max_y[lane], y[i + lane]);
+    }
+  }
+  for (; i < count; ++i)
+  {
+    min_x[0] = std::min(min_x[0], x[i]);
+    max_x[0] = std::max(max_x[0], x[i]);
+    min_y[0] = std::min(min_y[0], y[i]);
+    max_y[0] = std::max(max_y[0], y[i]);
+  }
+  return Envelope(*std::min_element(min_x, min_x + LANES), *std::max_element(max_x, max_x + LANES),
+                  *std::min_element(min_y, min_y + LANES), *std::max_element(max_y, max_y + LANES));
+}
+
+bool areaCentroid(const FlatPolygons &polygons, double &centroid_x, double &centroid_y)
+{
+  if (polygons.x.empty())
+  {
+    return false;
+  }
+
+  /*
+   * Per ring, twice the area and the first moments relative to its first
+   * point; shells count positive and holes negative whatever their
+   * orientation, like GEOS's Centroid. The rings are combined relative to
+   * the geometry's first point.
+   */
+  double base_x = polygons.x[0];
+  double base_y = polygons.y[0];
+  double area2 = 0.0;
+  double moment_x = 0.0;
+  double moment_y = 0.0;
+  for (size_t polygon = 0; polygon < polygons.polygonCount(); ++polygon)
+  {
+    for (size_t ring = polygons.polygon_rings[polygon]; ring < polygons.polygon_rings[polygon + 1]; ++ring)
+    {
+      size_t start = polygons.ring_starts[ring];
+      size_t count = ringSize(polygons, ring);
+      if (count < 3)
+      {
+        continue;
+      }
+      const double *x = &polygons.x[start];
+      const double *y = &polygons.y[start];
+      double x0 = x[0];
+      double y0 = y[0];
+      auto cross = [&](size_t i)
+      { return (x[i] - x0) * (y[i + 1] - y0) - (x[i + 1] - x0) * (y[i] - y0); };
+      double ring_area2 = laneSum(count - 1, cross);
+      double ring_moment_x = laneSum(count - 1, [&](size_t i)
+                                     { return (x[i] + x[i + 1] - 2.0 * x0) * cross(i); });
+      double ring_moment_y = laneSum(count - 1, [&](size_t i)
+                                     { return (y[i] + y[i + 1] - 2.0 * y0) * cross(i); });
+
+      bool shell = ring == polygons.polygon_rings[polygon];
+      double sign = (ring_area2 >= 0.0) == shell ? 1.0 : -1.0;
+      area2 += sign * ring_area2;
+      moment_x += sign * (ring_moment_x / 3.0 + ring_area2 * (x0 - base_x));
+      moment_y += sign * (ring_moment_y / 3.0 + ring_area2 * (y0 - base_y));
+    }
+  }
+  if (area2 == 0.0)
+  {
+    return false;
+  }
+  centroid_x = base_x + moment_x / area2;
+  centroid_y = base_y + moment_y / area2;
+  return true;
+}
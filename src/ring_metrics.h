@@ -0,0 +1,60 @@
+/*
+ * Area, perimeter, envelope and centroid kernels over flattened polygons.
+ *
+ * Geometry::getArea() and friends walk every ring through its
+ * CoordinateSequence point by point. flattenPolygons() copies the rings of
+ * a Polygon or MultiPolygon once into separate x and y arrays, and the
+ * kernels then run over those with a fixed number of operations per point
+ * and independent partial sums, so the compiler can vectorize them (AVX2 or
+ * NEON lanes at -O2 and up). Coordinates are taken relative to each ring's
+ * first point, as GEOS does, to keep the products small.
+ *
+ * The partial sums add up in a different order than GEOS's, so results can
+ * differ from it in the last bits; bench/metrics_bench.cpp checks them
+ * against GEOS.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <geos/geom/Envelope.h>
+#include <geos/geom/Geometry.h>
+
+struct FlatPolygons
+{
+  std::vector<double> x;             // Every ring's coordinates (closing point included), ring after ring
+  std::vector<double> y;
+  std::vector<size_t> ring_starts;   // Offset of each ring in x/y, followed by the end
+  std::vector<size_t> polygon_rings; // First ring (the shell) of each polygon, followed by the end
+
+  size_t polygonCount() const { return polygon_rings.size() - 1; }
+};
+
+/* Rings of a Polygon or MultiPolygon; no polygons for other types */
+FlatPolygons flattenPolygons(const geos::geom::Geometry &geometry);
+
+/* Twice the signed area of the closed ring x/y[0, count): positive if counter-clockwise */
+double ringDoubleSignedArea(const double *x, const double *y, size_t count);
+
+/* Length of the ring x/y[0, count) */
+double ringLength(const double *x, const double *y, size_t count);
+
+/* Shell area minus hole areas of one polygon, as Polygon::getArea() */
+double polygonArea(const FlatPolygons &polygons, size_t polygon);
+
+/* Sum of the polygon areas, as Geometry::getArea() */
+double totalArea(const FlatPolygons &polygons);
+
+/* Sum of every ring's length, as Geometry::getLength() */
+double totalLength(const FlatPolygons &polygons);
+
+/* Envelope of every coordinate (null if there are none) */
+geos::geom::Envelope envelopeOf(const FlatPolygons &polygons);
+
+/*
+ * Area-weighted centroid, as Geometry::getCentroid() of polygons. False if
+ * the total area is zero, where GEOS falls back to the rings' centroid.
+ */
+bool areaCentroid(const FlatPolygons &polygons, double &centroid_x, double &centroid_y);